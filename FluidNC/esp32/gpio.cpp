@@ -17,6 +17,20 @@ static gpio_dev_t* _gpio_dev = GPIO_HAL_GET_HW(GPIO_PORT_0);
 void IRAM_ATTR gpio_write(pinnum_t pin, bool value) {
     gpio_ll_set_level(_gpio_dev, (gpio_num_t)pin, value);
 }
+void IRAM_ATTR gpio_write_mask(uint64_t set_mask, uint64_t clear_mask) {
+    if (uint32_t(set_mask)) {
+        _gpio_dev->out_w1ts = uint32_t(set_mask);
+    }
+    if (uint32_t(clear_mask)) {
+        _gpio_dev->out_w1tc = uint32_t(clear_mask);
+    }
+    if (set_mask >> 32) {
+        _gpio_dev->out1_w1ts.val = uint32_t(set_mask >> 32);
+    }
+    if (clear_mask >> 32) {
+        _gpio_dev->out1_w1tc.val = uint32_t(clear_mask >> 32);
+    }
+}
 bool IRAM_ATTR gpio_read(pinnum_t pin) {
     return gpio_ll_get_level(_gpio_dev, (gpio_num_t)pin);
 }
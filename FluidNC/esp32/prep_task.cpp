@@ -0,0 +1,61 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Driver/prep_task.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_attr.h>  // IRAM_ATTR
+
+static TaskHandle_t      prepTask  = nullptr;
+static SemaphoreHandle_t prepMutex = nullptr;
+static void (*prepFn)();
+static TickType_t prepPollTicks;
+
+static void prep_task_loop(void* unused) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, prepPollTicks);
+        prepFn();
+    }
+}
+
+bool prep_task_start(void (*fn)(), int core, int priority, int poll_ms) {
+    if (prepTask) {
+        return true;
+    }
+    prepFn        = fn;
+    prepPollTicks = pdMS_TO_TICKS(poll_ms) ? pdMS_TO_TICKS(poll_ms) : 1;
+    prepMutex     = xSemaphoreCreateRecursiveMutex();
+    if (!prepMutex) {
+        return false;
+    }
+    return xTaskCreatePinnedToCore(prep_task_loop, "prep", 4096, nullptr, priority, &prepTask, core) == pdPASS;
+}
+
+// pulse_func() runs in the timer ISR, or in the I2S task when streaming.
+void IRAM_ATTR prep_task_wake() {
+    if (!prepTask) {
+        return;
+    }
+    if (xPortInIsrContext()) {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(prepTask, &higherPriorityTaskWoken);
+        if (higherPriorityTaskWoken) {
+            portYIELD_FROM_ISR();
+        }
+    } else {
+        xTaskNotifyGive(prepTask);
+    }
+}
+
+void prep_task_lock() {
+    if (prepMutex && !xPortInIsrContext()) {
+        xSemaphoreTakeRecursive(prepMutex, portMAX_DELAY);
+    }
+}
+
+void prep_task_unlock() {
+    if (prepMutex && !xPortInIsrContext()) {
+        xSemaphoreGiveRecursive(prepMutex);
+    }
+}
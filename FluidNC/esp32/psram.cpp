@@ -0,0 +1,13 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Driver/psram.h"
+
+#include <esp_heap_caps.h>
+
+void* psram_calloc(size_t count, size_t size) {
+    return heap_caps_calloc(count, size, MALLOC_CAP_SPIRAM);
+}
+
+void psram_free(void* ptr) {
+    heap_caps_free(ptr);
+}
@@ -12,6 +12,11 @@ void stepTimerStop();
 void stepTimerSetTicks(uint32_t ticks);
 void stepTimerStart();
 
+// Gives a timer that is not driven by hardware interrupts - e.g. the virtual
+// clock in the host simulator - a chance to run the step ISR.  Called from the
+// realtime loop; it does nothing on real hardware.
+void stepTimerPoll();
+
 #ifdef __cplusplus
 }
 #endif
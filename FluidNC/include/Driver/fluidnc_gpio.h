@@ -8,6 +8,9 @@
 // GPIO interface
 
 void gpio_write(pinnum_t pin, bool value);
+// Sets the pins in set_mask and clears those in clear_mask, bit n being GPIO n, with
+// one register write per bank so the pins change together.
+void gpio_write_mask(uint64_t set_mask, uint64_t clear_mask);
 bool gpio_read(pinnum_t pin);
 void gpio_mode(pinnum_t pin, bool input, bool output, bool pullup, bool pulldown, bool opendrain = false);
 void gpio_set_interrupt_type(pinnum_t pin, int mode);
@@ -0,0 +1,16 @@
+#pragma once
+
+// A task that runs the step segment generator on its own core, so that it is not held up by
+// the protocol loop.  The step ISR wakes it when the segment buffer runs low.
+
+// Starts a task, pinned to core, that calls fn each time it is woken and at least every
+// poll_ms.  Returns false if the platform has no tasks, leaving the protocol loop to call fn.
+bool prep_task_start(void (*fn)(), int core, int priority, int poll_ms);
+
+// Wakes the task.  Safe to call from the step ISR.
+void prep_task_wake();
+
+// A recursive lock held while running fn, and by anything else that touches the planner or
+// segment generator state.  It does nothing when called from an ISR or when there is no task.
+void prep_task_lock();
+void prep_task_unlock();
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+
+// Allocates zeroed memory from external PSRAM.  Returns nullptr if the board has none
+// or it is exhausted, so callers can fall back to the internal heap.
+void* psram_calloc(size_t count, size_t size);
+void  psram_free(void* ptr);
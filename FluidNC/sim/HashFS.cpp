@@ -0,0 +1,37 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Host version of src/HashFS.cpp, which needs mbedtls for SHA256.  The
+// simulator does not serve files to WebUI, so no hashes are kept.
+
+#include "src/HashFS.h"
+#include "src/Logging.h"
+
+std::map<std::string, std::string> HashFS::localFsHashes;
+
+void HashFS::report_change() {
+    log_msg("Files changed");
+}
+
+bool HashFS::file_is_hashed(const std::filesystem::path& path) {
+    return false;
+}
+void HashFS::delete_file(const std::filesystem::path& path, bool report) {
+    if (report) {
+        report_change();
+    }
+}
+void HashFS::rehash_file(const std::filesystem::path& path, bool report) {
+    if (report) {
+        report_change();
+    }
+}
+void HashFS::rename_file(const std::filesystem::path& ipath, const std::filesystem::path& opath, bool report) {
+    if (report) {
+        report_change();
+    }
+}
+void HashFS::hash_all() {}
+
+std::string HashFS::hash(const std::filesystem::path& path) {
+    return std::string();
+}
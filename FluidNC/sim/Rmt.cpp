@@ -0,0 +1,110 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// The RMT registers and memory are the plain variables in X86TestSupport's
+// driver/rmt.cpp, so a transmission is seen only once the ISR that started
+// it has returned.  That is also when the hardware would begin sending, to
+// within the ISR's own run time.
+
+#include "SimRmt.h"
+#include "SimClock.h"
+#include "StepTrace.h"
+
+#include <driver/rmt.h>
+#include <soc/soc.h>  // APB_CLK_FREQ
+
+#include <vector>
+
+struct RmtEdge {
+    uint64_t ticks;
+    bool     level;
+};
+
+static struct {
+    std::vector<RmtEdge> edges;  // Edges still to come, in time order
+    size_t               next;
+    bool                 level;  // Current output level
+} channels[RMT_CHANNEL_MAX];
+
+static void drive(int ch, uint64_t ticks, bool level) {
+    auto& c = channels[ch];
+    if (c.level != level) {
+        c.level = level;
+        stepTraceEdgeAt(ticks, uint8_t(rmt_host_gpio(rmt_channel_t(ch))), level);
+    }
+}
+
+// As on the ESP32, transmission ends at the first zero duration, and the
+// output returns to the idle level.
+static void start(int ch, uint64_t now) {
+    auto& c    = channels[ch];
+    auto& conf = RMT.conf_ch[ch];
+    c.edges.clear();
+    c.next = 0;
+
+    uint64_t divider = conf.conf0.div_cnt ? conf.conf0.div_cnt : 256;
+    uint64_t t       = 0;  // In APB clocks
+    for (int i = 0; i < SOC_RMT_MEM_WORDS_PER_CHANNEL; i++) {
+        rmt_item32_t item;
+        item.val = RMTMEM.chan[ch].data32[i].val;
+        if (!item.duration0) {
+            break;
+        }
+        c.edges.push_back({ t, bool(item.level0) });
+        t += item.duration0 * divider;
+        if (!item.duration1) {
+            break;
+        }
+        c.edges.push_back({ t, bool(item.level1) });
+        t += item.duration1 * divider;
+    }
+    c.edges.push_back({ t, bool(conf.conf1.idle_out_lv) });
+
+    for (auto& e : c.edges) {
+        e.ticks = now + e.ticks * simTicksPerSecond() / APB_CLK_FREQ;
+    }
+}
+
+static void stop(int ch, uint64_t now) {
+    auto& c = channels[ch];
+    c.edges.clear();
+    c.next = 0;
+    drive(ch, now, RMT.conf_ch[ch].conf1.idle_out_lv);
+}
+
+void simRmtUpdate() {
+    uint64_t now = simTicks();
+    for (int ch = 0; ch < RMT_CHANNEL_MAX; ch++) {
+        if (rmt_host_gpio(rmt_channel_t(ch)) < 0) {
+            continue;
+        }
+        auto& conf1 = RMT.conf_ch[ch].conf1;
+        if (conf1.tx_start) {
+            conf1.tx_start = 0;
+            start(ch, now);
+        } else if (channels[ch].next < channels[ch].edges.size() && RMTMEM.chan[ch].data32[0].val == 0) {
+            stop(ch, now);
+        }
+    }
+    // A transmission's first level applies at once
+    simRmtAdvance(now);
+}
+
+void simRmtAdvance(uint64_t ticks) {
+    while (true) {
+        int      first = -1;
+        uint64_t when  = ticks;
+        for (int ch = 0; ch < RMT_CHANNEL_MAX; ch++) {
+            auto& c = channels[ch];
+            // Ties go to the lowest channel
+            if (c.next < c.edges.size() && (c.edges[c.next].ticks < when || (first < 0 && c.edges[c.next].ticks == when))) {
+                first = ch;
+                when  = c.edges[c.next].ticks;
+            }
+        }
+        if (first < 0) {
+            return;
+        }
+        auto& c = channels[first];
+        drive(first, when, c.edges[c.next++].level);
+    }
+}
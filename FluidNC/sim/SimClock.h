@@ -0,0 +1,30 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Virtual time base for the host simulator.  The simulated step timer,
+// delay and GPIO drivers all share this clock, so a simulated job runs as
+// fast as the host can execute it while the recorded timing is exactly
+// what the step ISR asked for.
+
+#include <cstdint>
+
+// Current virtual time, in ticks of the step timer
+uint64_t simTicks();
+
+// Frequency of the step timer, as given to stepTimerInit()
+uint32_t simTicksPerSecond();
+
+// Amount of virtual time that each pass through the realtime loop consumes.
+// This models the main loop latency between calls to Stepper::prep_buffer().
+void simSetPollTicks(uint32_t ticks);
+
+// Advance the clock, running the step ISR at each alarm along the way
+void simRunFor(uint64_t ticks);
+
+// Number of step ISR invocations so far
+uint64_t simIsrCount();
+
+// Called after every step ISR with the host time it took, in nanoseconds,
+// for benchmarks of the ISR itself.  The virtual clock does not see it.
+void simSetIsrHook(void (*hook)(uint64_t host_ns));
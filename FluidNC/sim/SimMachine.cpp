@@ -0,0 +1,79 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "SimMachine.h"
+
+#include "src/Machine/MachineConfig.h"
+#include "src/Machine/Homing.h"
+#include "src/GCode.h"
+#include "src/Planner.h"
+#include "src/Stepper.h"
+#include "src/Protocol.h"
+#include "src/Settings.h"
+#include "src/System.h"
+#include "src/MotionControl.h"
+#include "src/Report.h"  // errorString
+#include "Driver/delay_usecs.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+bool simReadFile(const char* path, std::string& contents) {
+    std::ifstream     in(path, std::ios::binary);
+    std::stringstream buffer;
+    if (!in) {
+        return false;
+    }
+    buffer << in.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+bool simStartMachine(const std::string& yaml) {
+    timing_init();
+    protocol_init();
+    settings_init();
+    Machine::MachineConfig::load_yaml(yaml);
+    if (state_is(State::ConfigAlarm)) {
+        return false;
+    }
+
+    // Same order as setup() in Main.cpp, minus the hardware-only subsystems
+    config->_stepping->init();
+    plan_init();
+    config->_axes->init();
+    config->_kinematics->init();
+
+    // Same as a soft reset, with the machine assumed to be homed
+    system_reset();
+    gc_init();
+    plan_reset();
+    Stepper::reset();
+    plan_sync_position();
+    gc_sync_position();
+    mc_init();
+    Machine::Homing::set_all_axes_homed();
+    set_state(State::Idle);
+    return true;
+}
+
+int simRunProgram(std::istream& program, const char* name, int& lines) {
+    int         errors = 0;
+    std::string line;
+    lines = 0;
+    while (std::getline(program, line)) {
+        ++lines;
+        char buf[MAX_MESSAGE_LINE];
+        snprintf(buf, sizeof(buf), "%s", line.c_str());
+        Error status = gc_execute_line(buf);
+        if (status != Error::Ok) {
+            fprintf(stderr, "%s:%d: %s\n", name, lines, errorString(status));
+            ++errors;
+        }
+        if (sys.abort) {
+            break;
+        }
+    }
+    protocol_buffer_synchronize();
+    return errors;
+}
@@ -0,0 +1,21 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Machine bring-up and G-code execution shared by the simulator programs.
+
+#include <istream>
+#include <string>
+
+// Reads a whole file into contents, returning false if it cannot be read
+bool simReadFile(const char* path, std::string& contents);
+
+// Loads a machine configuration and starts the motion system the way
+// setup() in Main.cpp and a soft reset would, with the machine homed.
+// Returns false if the configuration has errors.
+bool simStartMachine(const std::string& yaml);
+
+// Runs a G-code program line by line through the parser and waits for
+// the resulting motion to finish.  Errors are reported on stderr with the
+// program name and line number.  Returns the number of lines that failed.
+int simRunProgram(std::istream& program, const char* name, int& lines);
@@ -0,0 +1,18 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Emulation of the RMT transmitters that the RMT stepping engine drives.
+// The step ISR starts a channel by setting its tx_start bit, after which
+// the channel plays the items in its RMT memory onto the GPIO that
+// rmt_config() routed it to, one RMT tick per clk_div APB clocks.
+
+#include <cstdint>
+
+// Starts the transmissions that the step ISR just asked for, and stops
+// those that it pointed at an end marker.  Called after every ISR.
+void simRmtUpdate();
+
+// Records the output edges of the running transmissions up to and
+// including virtual time ticks, in time order.
+void simRmtAdvance(uint64_t ticks);
@@ -0,0 +1,38 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Host version of esp32/StartupLog.cpp.  There is no RTC RAM to survive a
+// panic, so the log is an ordinary string.
+
+#include "src/StartupLog.h"
+#include "src/Protocol.h"  // send_line()
+
+#include <string>
+
+static std::string _messages;
+
+void StartupLog::init() {
+    _messages.clear();
+}
+size_t StartupLog::write(uint8_t data) {
+    _messages += char(data);
+    return 1;
+}
+void StartupLog::dump(Channel& out) {
+    size_t start = 0;
+    while (start < _messages.size()) {
+        size_t end = _messages.find('\n', start);
+        if (end == std::string::npos) {
+            end = _messages.size();
+        }
+        std::string line = _messages.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        log_stream(out, line);
+        start = end + 1;
+    }
+}
+
+StartupLog::~StartupLog() {}
+
+StartupLog startupLog;
@@ -0,0 +1,96 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Virtual replacement for the ESP32 alarm timer used for step timing.
+// Like the hardware timer in esp32/StepTimer.cpp, the alarm auto-reloads,
+// so the ISR runs every "ticks" timer ticks until it returns false or the
+// timer is stopped.  Time only advances when the foreground calls
+// stepTimerPoll() (or simRunFor()), which keeps the simulation deterministic.
+// The emulated RMT channels in Rmt.cpp follow the same clock.
+
+#include "Driver/StepTimer.h"
+#include "SimClock.h"
+#include "SimRmt.h"
+
+#include <chrono>
+
+static bool (*timer_isr_callback)(void);
+
+static uint32_t timer_frequency = 20000000;
+static uint64_t now_ticks       = 0;
+static uint64_t alarm_ticks     = 0;
+static uint32_t period_ticks    = 0;
+static bool     running         = false;
+static uint32_t poll_ticks      = 20000;  // 1 ms at 20 MHz
+static uint64_t isr_count       = 0;
+static void (*isr_hook)(uint64_t host_ns);
+
+void stepTimerInit(uint32_t frequency, bool (*callback)(void)) {
+    timer_frequency    = frequency;
+    timer_isr_callback = callback;
+    running            = false;
+}
+
+void stepTimerStart() {
+    period_ticks = 10;  // Interrupt very soon to start the stepping
+    alarm_ticks  = now_ticks + period_ticks;
+    running      = true;
+}
+
+void stepTimerSetTicks(uint32_t ticks) {
+    period_ticks = ticks ? ticks : 1;
+}
+
+void stepTimerStop() {
+    running = false;
+}
+
+void stepTimerPoll() {
+    simRunFor(poll_ticks);
+}
+
+void simRunFor(uint64_t ticks) {
+    uint64_t end = now_ticks + ticks;
+    simRmtUpdate();  // The foreground may have stopped the channels
+    while (running && alarm_ticks <= end) {
+        simRmtAdvance(alarm_ticks);
+        now_ticks = alarm_ticks;
+        ++isr_count;
+        bool more;
+        if (isr_hook) {
+            auto start = std::chrono::steady_clock::now();
+            more       = timer_isr_callback();
+            isr_hook(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+        } else {
+            more = timer_isr_callback();
+        }
+        simRmtUpdate();
+        if (!more) {
+            running = false;
+            break;
+        }
+        // The ISR may have changed the period for the next segment
+        alarm_ticks = now_ticks + period_ticks;
+    }
+    simRmtAdvance(end);
+    now_ticks = end;
+}
+
+uint64_t simTicks() {
+    return now_ticks;
+}
+
+uint32_t simTicksPerSecond() {
+    return timer_frequency;
+}
+
+void simSetPollTicks(uint32_t ticks) {
+    poll_ticks = ticks;
+}
+
+uint64_t simIsrCount() {
+    return isr_count;
+}
+
+void simSetIsrHook(void (*hook)(uint64_t host_ns)) {
+    isr_hook = hook;
+}
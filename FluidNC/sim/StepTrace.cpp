@@ -0,0 +1,57 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "StepTrace.h"
+#include "SimClock.h"
+
+#include <cstdio>
+#include <cstring>
+
+static FILE*    trace_file  = nullptr;
+static uint64_t trace_edges = 0;
+static void (*trace_hook)(uint64_t ticks, uint8_t pin, bool level);
+
+bool stepTraceOpen(const char* path) {
+    trace_file = fopen(path, "wb");
+    if (!trace_file) {
+        return false;
+    }
+    StepTraceHeader header = {};
+    strncpy(header.magic, "FNCSTEP", sizeof(header.magic));
+    header.version          = 1;
+    header.ticks_per_second = simTicksPerSecond();
+    fwrite(&header, sizeof(header), 1, trace_file);
+    return true;
+}
+
+void stepTraceEdge(uint8_t pin, bool level) {
+    stepTraceEdgeAt(simTicks(), pin, level);
+}
+
+void stepTraceEdgeAt(uint64_t ticks, uint8_t pin, bool level) {
+    ++trace_edges;
+    if (trace_hook) {
+        trace_hook(ticks, pin, level);
+    }
+    if (trace_file) {
+        StepTraceRecord record = {};
+        record.ticks           = ticks;
+        record.pin             = pin;
+        record.level           = level;
+        fwrite(&record, sizeof(record), 1, trace_file);
+    }
+}
+
+void stepTraceClose() {
+    if (trace_file) {
+        fclose(trace_file);
+        trace_file = nullptr;
+    }
+}
+
+uint64_t stepTraceEdges() {
+    return trace_edges;
+}
+
+void stepTraceSetHook(void (*hook)(uint64_t ticks, uint8_t pin, bool level)) {
+    trace_hook = hook;
+}
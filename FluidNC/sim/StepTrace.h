@@ -0,0 +1,35 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Binary recording of the output edges produced by the step ISR.
+//
+// The file starts with a StepTraceHeader followed by one StepTraceRecord
+// per edge, all little-endian.  Every change of a GPIO output is recorded,
+// so step and direction pins can be told apart using the pin numbers in
+// the machine configuration.
+
+#include <cstdint>
+
+struct StepTraceHeader {
+    char     magic[8];          // "FNCSTEP"
+    uint32_t version;           // 1
+    uint32_t ticks_per_second;  // Unit of StepTraceRecord::ticks
+};
+
+struct StepTraceRecord {
+    uint64_t ticks;  // Virtual time of the edge
+    uint8_t  pin;    // GPIO number
+    uint8_t  level;  // New output level
+    uint8_t  reserved[6];
+};
+
+bool     stepTraceOpen(const char* path);
+void     stepTraceEdge(uint8_t pin, bool level);
+void     stepTraceEdgeAt(uint64_t ticks, uint8_t pin, bool level);  // For peripherals that run ahead of the clock
+void     stepTraceClose();
+uint64_t stepTraceEdges();
+
+// Also hands every edge to hook, at the current virtual time, whether or
+// not a trace file is open
+void stepTraceSetHook(void (*hook)(uint64_t ticks, uint8_t pin, bool level));
@@ -0,0 +1,63 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Host version of src/Uart.cpp, which drives the ESP32 UART hardware.  Output
+// goes to stdout, so that log messages and reports are visible, and nothing is
+// ever received.
+
+#include "src/Uart.h"
+
+#include <cstdio>
+
+Uart::Uart(int uart_num) : _uart_num(uart_num) {}
+
+void Uart::begin() {
+    begin(_baud, _dataBits, _stopBits, _parity);
+}
+void Uart::begin(unsigned long baud, UartData dataBits, UartStop stopBits, UartParity parity) {}
+
+int Uart::read() {
+    return -1;
+}
+int Uart::peek() {
+    return -1;
+}
+int Uart::available() {
+    return 0;
+}
+
+size_t Uart::write(uint8_t c) {
+    return write(&c, 1);
+}
+size_t Uart::write(const uint8_t* buffer, size_t length) {
+    return fwrite(buffer, 1, length, stdout);
+}
+
+size_t Uart::timedReadBytes(char* buffer, size_t len, TickType_t timeout) {
+    return 0;
+}
+
+void Uart::forceXon() {}
+void Uart::forceXoff() {}
+void Uart::setSwFlowControl(bool on, int xon_threshold, int xoff_threshold) {}
+bool Uart::setHalfDuplex() {
+    return false;
+}
+bool Uart::setPins(int tx_pin, int rx_pin, int rts_pin, int cts_pin) {
+    return false;
+}
+bool Uart::flushTxTimed(TickType_t ticks) {
+    fflush(stdout);
+    return false;
+}
+
+void Uart::config_message(const char* prefix, const char* usage) {
+    log_info(prefix << usage << " Tx:" << _txd_pin.name() << " Rx:" << _rxd_pin.name() << " RTS:" << _rts_pin.name() << " Baud:" << _baud);
+}
+
+int Uart::rx_buffer_available(void) {
+    return 128;
+}
+
+void Uart::flushRx() {
+    _pushback = -1;
+}
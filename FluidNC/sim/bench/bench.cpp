@@ -0,0 +1,338 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Step engine benchmark.
+//
+// Replays a fixed set of motion programs - rapids, arcs and a raster -
+// through the simulator, and reports for each one the step rates it needs
+// against the limit of every stepping engine, the host time spent in the
+// step ISR per call and per step, and a histogram of the change in step
+// period from one step to the next.  Everything but the host times is
+// computed on the virtual clock, so it is the same from run to run and can
+// be diffed between builds to catch regressions in the planner, the segment
+// generator or the ISR.
+//
+// Usage: fluidnc_sim_bench [config.yaml | Timed | RMT | RMT_burst] [poll_us]
+//
+// Without a configuration, a standard three-axis machine is used, so that
+// results from different builds are comparable.  Its stepping engine is
+// Timed unless another is named; RMT_burst is RMT with stepping/rmt_burst.
+
+#include "src/Machine/MachineConfig.h"
+#include "src/Motors/MotorDriver.h"
+#include "src/Stepper.h"
+#include "../SimClock.h"
+#include "../SimMachine.h"
+#include "../StepTrace.h"
+
+#include <driver/rmt.h>  // rmt_host_gpio()
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const char* standardStepping[][2] = { { "Timed", "engine: Timed" },
+                                              { "RMT", "engine: RMT" },
+                                              { "RMT_burst", "engine: RMT\n  rmt_burst: true" } };
+
+static const char* standardMachine = R"(
+name: Benchmark
+stepping:
+  %s
+  pulse_us: 2
+axes:
+  x:
+    steps_per_mm: 160
+    max_rate_mm_per_min: 15000
+    acceleration_mm_per_sec2: 1000
+    max_travel_mm: 1000
+    motor0:
+      standard_stepper:
+        step_pin: gpio.16
+        direction_pin: gpio.17
+  y:
+    steps_per_mm: 160
+    max_rate_mm_per_min: 15000
+    acceleration_mm_per_sec2: 1000
+    max_travel_mm: 1000
+    motor0:
+      standard_stepper:
+        step_pin: gpio.18
+        direction_pin: gpio.19
+  z:
+    steps_per_mm: 800
+    max_rate_mm_per_min: 3000
+    acceleration_mm_per_sec2: 300
+    max_travel_mm: 100
+    motor0:
+      standard_stepper:
+        step_pin: gpio.21
+        direction_pin: gpio.22
+)";
+
+struct Program {
+    const char* name;
+    std::string gcode;
+};
+
+// Long rapids on every axis, alone and together
+static std::string rapids() {
+    std::ostringstream g;
+    g << "G21 G90\n";
+    for (int pass = 0; pass < 3; pass++) {
+        g << "G0 X200\nG0 Y200\nG0 Z-20\nG0 X0 Y0 Z0\nG0 X200 Y100\nG0 X0 Y0\n";
+    }
+    return g.str();
+}
+
+// Full circles from tight to wide, slow and fast, where the step rates of X and Y change all the time
+static std::string arcs() {
+    std::ostringstream g;
+    g << "G21 G90 G17\n";
+    for (int radius : { 1, 5, 20, 50 }) {
+        for (int feed : { 1000, 6000 }) {
+            g << "G1 X" << 100 + radius << " Y100 F" << feed << "\n";
+            g << "G2 X" << 100 + radius << " Y100 I" << -radius << " J0\n";
+            g << "G3 X" << 100 + radius << " Y100 I" << -radius << " J0\n";
+        }
+    }
+    g << "G0 X0 Y0\n";
+    return g.str();
+}
+
+// Back and forth lines with short step-overs, as in laser engraving
+static std::string raster() {
+    std::ostringstream g;
+    g << "G21 G90\nG0 X10 Y10\nG1 F12000\n";
+    for (int line = 0; line < 100; line++) {
+        g << "G1 X" << (line % 2 ? 10 : 110) << "\n";
+        g << "G1 Y" << 10 + (line + 1) * 0.1 << "\n";
+    }
+    g << "G0 X0 Y0\n";
+    return g.str();
+}
+
+// Histogram buckets for the change in step period from one step of an axis to the next.  The
+// last bucket takes everything larger.  The virtual clock has no timing noise, so the changes
+// come from acceleration, from the segment boundaries and from rounding step times to timer or
+// RMT ticks.
+static const struct {
+    double      limit_us;
+    const char* label;
+} periodChangeBuckets[] = { { 0.1, "<0.1" }, { 1, "<1" },   { 2, "<2" },   { 5, "<5" },
+                            { 10, "<10" },   { 20, "<20" }, { 50, "<50" }, { 0, "more" } };
+static const int periodChangeBucketCount = sizeof(periodChangeBuckets) / sizeof(periodChangeBuckets[0]);
+
+// A pause longer than this, in us, starts a new run of steps rather than counting as a period change
+static const double runBreakUs = 10000;
+
+struct AxisStats {
+    int      step_pin;
+    bool     active_low;
+    uint64_t steps;
+    uint64_t last_step;
+    uint64_t last_interval;
+    uint64_t min_interval;
+    uint64_t period_change[periodChangeBucketCount];
+};
+
+static std::vector<AxisStats> axes;
+static double                 ticks_per_usec;
+
+static struct {
+    uint64_t calls;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} isr;
+
+static void on_isr(uint64_t host_ns) {
+    isr.calls++;
+    isr.total_ns += host_ns;
+    isr.max_ns = std::max(isr.max_ns, host_ns);
+}
+
+static void on_edge(uint64_t ticks, uint8_t pin, bool level) {
+    for (auto& a : axes) {
+        if (a.step_pin != pin || level == a.active_low) {
+            continue;
+        }
+        if (a.steps++) {
+            uint64_t interval = ticks - a.last_step;
+            if (interval < runBreakUs * ticks_per_usec) {
+                a.min_interval = std::min(a.min_interval, interval);
+                if (a.last_interval) {
+                    double change = double(interval > a.last_interval ? interval - a.last_interval : a.last_interval - interval);
+                    int    bucket = 0;
+                    while (bucket < periodChangeBucketCount - 1 && change >= periodChangeBuckets[bucket].limit_us * ticks_per_usec) {
+                        bucket++;
+                    }
+                    a.period_change[bucket]++;
+                }
+                a.last_interval = interval;
+            } else {
+                a.last_interval = 0;
+            }
+        }
+        a.last_step = ticks;
+    }
+}
+
+static uint32_t engine_limit(int engine) {
+    auto saved                 = Machine::Stepping::_engine;
+    Machine::Stepping::_engine = engine;
+    uint32_t limit             = config->_stepping->maxPulsesPerSec();
+    Machine::Stepping::_engine = saved;
+    return limit;
+}
+
+static int run(const Program& program) {
+    for (auto& a : axes) {
+        a = { a.step_pin, a.active_low, 0, 0, 0, UINT64_MAX, {} };
+    }
+    isr = {};
+    Stepper::reset_stats();
+    uint64_t start = simTicks();
+
+    std::istringstream in(program.gcode);
+    int                lines;
+    int                errors = simRunProgram(in, program.name, lines);
+
+    double   seconds = double(simTicks() - start) / simTicksPerSecond();
+    uint64_t steps   = 0;
+    uint64_t peak    = 0;
+    for (auto& a : axes) {
+        steps += a.steps;
+        if (a.min_interval != UINT64_MAX) {
+            peak = std::max(peak, uint64_t(simTicksPerSecond() / a.min_interval));
+        }
+    }
+
+    printf("%s: %d lines, %d errors, %.6f s\n", program.name, lines, errors, seconds);
+    printf("  step isr:  %llu calls, %.2f per step, host %.0f ns avg, %llu ns max, %.0f ns per step\n",
+           (unsigned long long)isr.calls,
+           steps ? double(isr.calls) / steps : 0.0,
+           isr.calls ? double(isr.total_ns) / isr.calls : 0.0,
+           (unsigned long long)isr.max_ns,
+           steps ? double(isr.total_ns) / steps : 0.0);
+    auto& stats = Stepper::stats;
+    printf("  segments:  low water %u, underruns %u\n", stats.low_water == UINT32_MAX ? 0 : stats.low_water, stats.underruns);
+
+    printf("  axis      steps   max rate/s\n");
+    auto n_axis = config->_axes->_numberAxis;
+    for (size_t axis = 0; axis < axes.size() && axis < n_axis; axis++) {
+        auto& a = axes[axis];
+        if (a.step_pin < 0) {
+            continue;
+        }
+        uint64_t rate = a.min_interval == UINT64_MAX ? 0 : simTicksPerSecond() / a.min_interval;
+        printf("  %c    %10llu %12llu\n", config->_axes->axisName(axis), (unsigned long long)a.steps, (unsigned long long)rate);
+    }
+
+    printf("  engine       limit/s  max rate %%\n");
+    static const struct {
+        int         engine;
+        const char* name;
+    } engines[] = { { Machine::Stepping::TIMED, "Timed" },
+                    { Machine::Stepping::RMT, "RMT" },
+                    { Machine::Stepping::I2S_STATIC, "I2S_static" },
+                    { Machine::Stepping::I2S_STREAM, "I2S_stream" } };
+    for (auto& e : engines) {
+        uint32_t limit = engine_limit(e.engine);
+        printf("  %-10s %9u %10.1f%s\n", e.name, limit, limit ? 100.0 * peak / limit : 0.0, peak > limit ? "  too slow" : "");
+    }
+
+    printf("  period change us");
+    for (auto& bucket : periodChangeBuckets) {
+        printf(" %7s", bucket.label);
+    }
+    printf("\n");
+    for (size_t axis = 0; axis < axes.size() && axis < n_axis; axis++) {
+        auto& a = axes[axis];
+        if (a.step_pin < 0) {
+            continue;
+        }
+        printf("  %c               ", config->_axes->axisName(axis));
+        for (auto count : a.period_change) {
+            printf(" %7llu", (unsigned long long)count);
+        }
+        printf("\n");
+    }
+    printf("\n");
+    return errors;
+}
+
+int main(int argc, char** argv) {
+    const char* stepping = standardStepping[0][1];
+    bool        standard = true;
+    if (argc > 1) {
+        standard = false;
+        for (auto& choice : standardStepping) {
+            if (!strcmp(argv[1], choice[0])) {
+                stepping = choice[1];
+                standard = true;
+            }
+        }
+    }
+    std::string yaml;
+    if (standard) {
+        char buf[2048];
+        snprintf(buf, sizeof(buf), standardMachine, stepping);
+        yaml = buf;
+    } else if (!simReadFile(argv[1], yaml)) {
+        fprintf(stderr, "Cannot read configuration %s\n", argv[1]);
+        return 2;
+    }
+    if (!simStartMachine(yaml)) {
+        fprintf(stderr, "Configuration error in %s\n", standard ? "the standard machine" : argv[1]);
+        return 1;
+    }
+    if (argc > 2) {
+        simSetPollTicks(uint32_t(uint64_t(atoi(argv[2])) * simTicksPerSecond() / 1000000));
+    }
+
+    // Steps are counted on the step pin of the first motor of each axis.  With the RMT engine,
+    // that pin belongs to an RMT channel, and motors take channels in the order that
+    // Axes::init() visits them.
+    ticks_per_usec  = simTicksPerSecond() / 1e6;
+    auto n_axis     = config->_axes->_numberAxis;
+    bool rmt        = Machine::Stepping::_engine == Machine::Stepping::RMT;
+    int  rmtChannel = 0;
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        AxisStats a = {};
+        a.step_pin  = -1;
+        for (size_t motor = 0; motor < Machine::Axis::MAX_MOTORS_PER_AXIS; motor++) {
+            auto m = config->_axes->_axis[axis]->_motors[motor];
+            if (!m) {
+                continue;
+            }
+            pinnum_t gpio = 0;
+            bool     active_low;
+            if (m->_driver->direct_step_pin(gpio, active_low)) {
+                if (motor == 0) {
+                    a.step_pin   = gpio;
+                    a.active_low = active_low;
+                }
+            } else if (rmt) {
+                int rmtGpio = rmt_host_gpio(rmt_channel_t(rmtChannel++));
+                if (motor == 0 && rmtGpio >= 0) {
+                    a.step_pin   = rmtGpio;
+                    a.active_low = RMT.conf_ch[rmtChannel - 1].conf1.idle_out_lv;
+                }
+            }
+        }
+        axes.push_back(a);
+    }
+    simSetIsrHook(on_isr);
+    stepTraceSetHook(on_edge);
+
+    const Program programs[] = { { "rapids", rapids() }, { "arcs", arcs() }, { "raster", raster() } };
+
+    int errors = 0;
+    for (auto& program : programs) {
+        errors += run(program);
+    }
+    return errors ? 1 : 0;
+}
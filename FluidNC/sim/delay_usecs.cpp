@@ -0,0 +1,31 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Short delays on the virtual clock.  The step ISR runs to completion at a
+// single instant of virtual time, so busy-waits for pulse widths and
+// direction delays return immediately instead of spinning forever on a
+// clock that cannot advance underneath them.
+
+#include "Driver/delay_usecs.h"
+#include "SimClock.h"
+
+uint32_t ticks_per_us;
+
+void timing_init() {
+    ticks_per_us = 240;  // Pretend to be a 240 MHz ESP32
+}
+
+void delay_us(int32_t us) {}
+
+int32_t usToCpuTicks(int32_t us) {
+    return us * ticks_per_us;
+}
+
+int32_t usToEndTicks(int32_t us) {
+    return getCpuTicks() + usToCpuTicks(us);
+}
+
+void spinUntil(int32_t endTicks) {}
+
+int32_t getCpuTicks() {
+    return int32_t(simTicks() * ticks_per_us * 1000000 / simTicksPerSecond());
+}
@@ -0,0 +1,96 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Inert versions of the platform drivers that motion simulation does not
+// exercise.  They report failure where the firmware checks for it, so the
+// corresponding subsystems stay disabled in the simulator.
+
+#include "Driver/PwmPin.h"
+#include "Driver/fluidnc_i2c.h"
+#include "Driver/spi.h"
+#include "Driver/sdspi.h"
+#include "Driver/localfs.h"
+#include "Driver/littlefs.h"
+#include "Driver/spiffs.h"
+#include "Driver/psram.h"
+#include "Driver/prep_task.h"
+
+PwmPin::PwmPin(Pin& pin, uint32_t frequency) : _frequency(frequency), _channel(0), _period(1), _gpio(0) {}
+PwmPin::~PwmPin() {}
+void PwmPin::setDuty(uint32_t duty) {}
+
+bool i2c_master_init(int bus_number, pinnum_t sda_pin, pinnum_t scl_pin, uint32_t frequency) {
+    return true;
+}
+int i2c_write(int bus_number, uint8_t address, const uint8_t* data, size_t count) {
+    return -1;
+}
+int i2c_read(int bus_number, uint8_t address, uint8_t* data, size_t count) {
+    return -1;
+}
+
+bool spi_init_bus(pinnum_t sck_pin, pinnum_t miso_pin, pinnum_t mosi_pin, bool dma) {
+    return false;
+}
+void         spi_deinit_bus() {}
+spi_device_t spi_register_device(pinnum_t cs_pin) {
+    return -1;
+}
+void spi_unregister_device(spi_device_t devid) {}
+bool spi_transfer(spi_device_t busid, uint8_t* outbuf, uint8_t* inbuf, size_t len) {
+    return false;
+}
+
+bool sd_init_slot(uint32_t freq_hz, int cs_pin, int cd_pin, int wp_pin) {
+    return false;
+}
+void            sd_unmount() {}
+void            sd_deinit_slot() {}
+std::error_code sd_mount(int max_files) {
+    return std::make_error_code(std::errc::no_such_device);
+}
+
+const char* localfsName    = "";
+const char* littlefs_label = littlefsName;
+
+bool localfs_format(const char* fsname) {
+    return true;
+}
+bool localfs_mount() {
+    return true;
+}
+void        localfs_unmount() {}
+const char* canonicalPath(const char* filename, const char* defaultFs) {
+    return filename;
+}
+std::uintmax_t localfs_size() {
+    return 0;
+}
+
+bool littlefs_format(const char* partition_label) {
+    return true;
+}
+bool littlefs_mount(const char* label, bool format) {
+    return true;
+}
+void littlefs_unmount() {}
+
+bool spiffs_format(const char* partition_label) {
+    return true;
+}
+bool spiffs_mount(const char* label, bool format) {
+    return true;
+}
+void spiffs_unmount() {}
+
+void* psram_calloc(size_t count, size_t size) {
+    return nullptr;
+}
+void psram_free(void* ptr) {}
+
+// The virtual clock only advances in the protocol loop, so segments are prepped there too.
+bool prep_task_start(void (*fn)(), int core, int priority, int poll_ms) {
+    return false;
+}
+void prep_task_wake() {}
+void prep_task_lock() {}
+void prep_task_unlock() {}
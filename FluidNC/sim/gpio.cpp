@@ -0,0 +1,38 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Simulated GPIO outputs.  Writes only matter for their timing, which is
+// recorded in the step trace whenever the level of an output changes.
+
+#include "Driver/fluidnc_gpio.h"
+#include "StepTrace.h"
+
+static bool output_levels[256];
+
+void gpio_write(pinnum_t pin, bool value) {
+    if (output_levels[pin] != value) {
+        output_levels[pin] = value;
+        stepTraceEdge(pin, value);
+    }
+}
+void gpio_write_mask(uint64_t set_mask, uint64_t clear_mask) {
+    for (pinnum_t pin = 0; pin < 64; pin++) {
+        if ((set_mask >> pin) & 1) {
+            gpio_write(pin, true);
+        } else if ((clear_mask >> pin) & 1) {
+            gpio_write(pin, false);
+        }
+    }
+}
+bool gpio_read(pinnum_t pin) {
+    return output_levels[pin];
+}
+void gpio_mode(pinnum_t pin, bool input, bool output, bool pullup, bool pulldown, bool opendrain) {}
+void gpio_set_interrupt_type(pinnum_t pin, int mode) {}
+void gpio_add_interrupt(pinnum_t pin, int mode, void (*callback)(void*), void* arg) {}
+void gpio_remove_interrupt(pinnum_t pin) {}
+void gpio_route(pinnum_t pin, uint32_t signal) {}
+void gpio_dump(Print& out) {}
+
+void gpio_set_action(int gpio_num, gpio_dispatch_t action, void* arg, bool invert) {}
+void gpio_clear_action(int gpio_num) {}
+void poll_gpios() {}
@@ -0,0 +1,68 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Host-native motion simulator.
+//
+// Runs a G-code program through the real parser, kinematics, planner and
+// step segment generator, with the step ISR driven by the virtual clock in
+// StepTimer.cpp instead of hardware.  The result is a deterministic cycle
+// time and, optionally, a binary trace of every step and direction edge.
+//
+// Usage: fluidnc_sim <config.yaml> <program.nc> [trace.bin] [poll_us]
+
+#include "src/Machine/MachineConfig.h"
+#include "SimClock.h"
+#include "SimMachine.h"
+#include "StepTrace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <config.yaml> <program.nc> [trace.bin] [poll_us]\n", argv[0]);
+        return 2;
+    }
+
+    std::string yaml;
+    if (!simReadFile(argv[1], yaml)) {
+        fprintf(stderr, "Cannot read configuration %s\n", argv[1]);
+        return 2;
+    }
+    std::ifstream program(argv[2]);
+    if (!program) {
+        fprintf(stderr, "Cannot read program %s\n", argv[2]);
+        return 2;
+    }
+
+    if (!simStartMachine(yaml)) {
+        fprintf(stderr, "Configuration error in %s\n", argv[1]);
+        return 1;
+    }
+
+    if (argc > 3 && !stepTraceOpen(argv[3])) {
+        fprintf(stderr, "Cannot create trace %s\n", argv[3]);
+        return 2;
+    }
+    if (argc > 4) {
+        simSetPollTicks(uint32_t(uint64_t(atoi(argv[4])) * simTicksPerSecond() / 1000000));
+    }
+
+    int line_no;
+    int errors = simRunProgram(program, argv[2], line_no);
+    stepTraceClose();
+
+    double seconds = double(simTicks()) / simTicksPerSecond();
+    printf("lines:      %d\n", line_no);
+    printf("errors:     %d\n", errors);
+    printf("cycle time: %.6f s\n", seconds);
+    printf("isr calls:  %llu\n", (unsigned long long)simIsrCount());
+    printf("edges:      %llu\n", (unsigned long long)stepTraceEdges());
+    auto n_axis = config->_axes->_numberAxis;
+    for (int axis = 0; axis < n_axis; axis++) {
+        auto m = config->_axes->_axis[axis]->_motors[0];
+        printf("%c steps:    %d\n", config->_axes->axisName(axis), m ? m->_steps : 0);
+    }
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Input-shaped moves run through the real planner and segment generator on the simulator.  The
+// step edges in the trace must add up to the programmed moves, and the dominant axis must stay
+// within its acceleration limit although shaping raises the peak of every ramp.
+
+#include "gtest/gtest.h"
+
+#include "src/Machine/MachineConfig.h"
+#include "../SimClock.h"
+#include "../SimMachine.h"
+#include "../StepTrace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    const char* shapedMachine = R"(
+name: Shaper test
+stepping:
+  engine: Timed
+  pulse_us: 2
+axes:
+  x:
+    steps_per_mm: 160
+    max_rate_mm_per_min: 15000
+    acceleration_mm_per_sec2: 1000
+    max_travel_mm: 1000
+    shaper_type: %s
+    shaper_frequency_hz: 25
+    motor0:
+      standard_stepper:
+        step_pin: gpio.16
+        direction_pin: gpio.17
+  y:
+    steps_per_mm: 100
+    max_rate_mm_per_min: 15000
+    acceleration_mm_per_sec2: 1000
+    max_travel_mm: 1000
+    motor0:
+      standard_stepper:
+        step_pin: gpio.18
+        direction_pin: gpio.19
+)";
+
+    const int    xStepPin   = 16;
+    const int    yStepPin   = 18;
+    const double xStepsPerMm = 160;
+    const double yStepsPerMm = 100;
+    const double xAccelLimit = 1000;  // mm/s^2
+
+    struct Trace {
+        std::vector<uint64_t> x_steps;  // Times of the X step pulses
+        uint64_t              y_steps;
+    } trace;
+
+    void record(uint64_t ticks, uint8_t pin, bool level) {
+        if (!level) {
+            return;
+        }
+        if (pin == xStepPin) {
+            trace.x_steps.push_back(ticks);
+        } else if (pin == yStepPin) {
+            trace.y_steps++;
+        }
+    }
+
+    struct Move {
+        double x, y, feed;
+    };
+
+    // Long and short moves, reversals and diagonals, so that every block ramps, many ramps are
+    // shaped, and some are too short to shape
+    const Move moves[] = { { 100, 0, 12000 },  { 100.3, 0, 12000 }, { 20, 0, 12000 },    { 20, 40, 9000 },   { 80, 52.7, 12000 },
+                           { 79.9, 52.7, 600 }, { 0, 0, 15000 },      { 3.3, 0.7, 15000 },  { 150, 30, 3000 },  { 150.05, 30, 3000 },
+                           { 10, 10, 15000 },   { 60, 10, 1200 },     { 60, 10.5, 12000 },  { 0, 0, 12000 } };
+
+    int32_t to_steps(double mm, double steps_per_mm) { return int32_t(std::lround(mm * steps_per_mm)); }
+
+    // Peak acceleration in mm/s^2 from step times, using the position sampled every dt seconds so
+    // that whole-step quantization does not swamp it
+    double peak_acceleration(const std::vector<uint64_t>& steps, double ticks_per_second, double steps_per_mm, double dt) {
+        auto position = [&](double t) {
+            uint64_t ticks = uint64_t(t * ticks_per_second);
+            size_t   i     = std::upper_bound(steps.begin(), steps.end(), ticks) - steps.begin();
+            if (i == 0 || i >= steps.size()) {
+                return double(i);
+            }
+            double t0 = steps[i - 1] / ticks_per_second;
+            double t1 = steps[i] / ticks_per_second;
+            return i - 1 + (t - t0) / (t1 - t0);
+        };
+        double end  = steps.back() / ticks_per_second;
+        double peak = 0;
+        for (double t = dt; t + dt < end; t += dt) {
+            double a = (position(t + dt) - 2 * position(t) + position(t - dt)) / (dt * dt * steps_per_mm);
+            peak     = std::max(peak, fabs(a));
+        }
+        return peak;
+    }
+}
+
+class ShaperSteps : public ::testing::TestWithParam<const char*> {};
+
+TEST_P(ShaperSteps, TraceMatchesProgram) {
+    char yaml[2048];
+    snprintf(yaml, sizeof(yaml), shapedMachine, GetParam());
+    ASSERT_TRUE(simStartMachine(yaml));
+    ASSERT_TRUE(config->_axes->_axis[0]->_shaper.n_impulses);
+
+    std::ostringstream program;
+    program << "G21 G90\n";
+    int32_t x_expected = 0, y_expected = 0;
+    int32_t x_from = 0, y_from = 0;
+    for (auto& m : moves) {
+        program << "G1 X" << m.x << " Y" << m.y << " F" << m.feed << "\n";
+        int32_t x_to = to_steps(m.x, xStepsPerMm);
+        int32_t y_to = to_steps(m.y, yStepsPerMm);
+        x_expected += abs(x_to - x_from);
+        y_expected += abs(y_to - y_from);
+        x_from = x_to;
+        y_from = y_to;
+    }
+
+    trace = {};
+    stepTraceSetHook(record);
+    std::istringstream in(program.str());
+    int                lines;
+    EXPECT_EQ(simRunProgram(in, GetParam(), lines), 0);
+    stepTraceSetHook(nullptr);
+
+    EXPECT_EQ(int32_t(trace.x_steps.size()), x_expected);
+    EXPECT_EQ(int32_t(trace.y_steps), y_expected);
+    EXPECT_EQ(config->_axes->_axis[0]->_motors[0]->_steps, x_from);
+    EXPECT_EQ(config->_axes->_axis[1]->_motors[0]->_steps, y_from);
+
+    ASSERT_FALSE(trace.x_steps.empty());
+    double peak = peak_acceleration(trace.x_steps, simTicksPerSecond(), xStepsPerMm, 0.01);
+    EXPECT_LE(peak, xAccelLimit * 1.02) << "shaped ramps exceed the X acceleration limit";
+}
+
+INSTANTIATE_TEST_SUITE_P(Shapers, ShaperSteps, ::testing::Values("ZV", "ZVD", "EI"));
@@ -46,6 +46,10 @@ const int C2_AXIS = (C_AXIS + MAX_N_AXIS);
 
 const int SUPPORT_TASK_CORE = 0;  // Reference: CONFIG_ARDUINO_RUNNING_CORE = 1
 
+// Priority of the step segment prep task, if stepping/prep_task is enabled.  It runs on
+// SUPPORT_TASK_CORE and must preempt the poller and output tasks there.
+const int PREP_TASK_PRIORITY = 5;
+
 // Serial baud rate
 // OK to change, but the ESP32 boot text is 115200, so you will not see that is your
 // serial monitor, sender, etc uses a different value than 115200
@@ -107,6 +111,14 @@ namespace RapidOverride {
     const int ExtraLow = 5;    // Percent of rapid (1-99). Usually 5%.  Not Supported
 };
 
+// Automatic slowdown when the step segment buffer runs low; see stepping/underrun_guard_ms.
+namespace UnderrunScale {
+    const int Default   = 100;  // 100%. Don't change this value.
+    const int Min       = 50;   // Percent of the commanded speed it may slow to (1-100).
+    const int Decrement = 10;   // Taken off each time the buffer runs low (1-99).
+    const int Increment = 5;    // Given back after each second with the buffer healthy (1-99).
+};
+
 namespace SpindleSpeedOverride {
     const int Default         = 100;  // 100%. Don't change this value.
     const int Max             = 200;  // Percent of programmed spindle speed (100-255). Usually 200%.
@@ -134,15 +146,6 @@ const int REPORT_OVR_REFRESH_IDLE_COUNT = 10;  // (1-255) Must be less than or e
 const int REPORT_WCO_REFRESH_BUSY_COUNT = 30;  // (2-255)
 const int REPORT_WCO_REFRESH_IDLE_COUNT = 10;  // (2-255) Must be less than or equal to the busy count
 
-// The temporal resolution of the acceleration management subsystem. A higher number gives smoother
-// acceleration, particularly noticeable on machines that run at very high feedrates, but may negatively
-// impact performance. The correct value for this parameter is machine dependent, so it's advised to
-// set this only as high as needed. Approximate successful values can widely range from 50 to 200 or more.
-// NOTE: Changing this value also changes the execution time of a segment in the step segment buffer.
-// When increasing this value, this stores less overall time in the segment buffer and vice versa. Make
-// certain the step segment buffer is increased/decreased to account for these changes.
-const int ACCELERATION_TICKS_PER_SECOND = 100;
-
 // Sets which axis the tool length offset is applied. Assumes the spindle is always parallel with
 // the selected axis with the tool oriented toward the negative direction. In other words, a positive
 // tool length offset value is subtracted from the current location.
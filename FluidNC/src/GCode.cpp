@@ -466,8 +466,12 @@ Error gc_execute_line(char* line) {
                         if (mantissa != 0) {
                             FAIL(Error::GcodeUnsupportedCommand);  // [G61.1 not supported]
                         }
-                        // gc_block.modal.control = ControlMode::ExactPath; // G61
-                        mg_word_bit = ModalGroup::MG13;
+                        gc_block.modal.control = ControlMode::ExactPath;  // G61
+                        mg_word_bit            = ModalGroup::MG13;
+                        break;
+                    case 64:
+                        gc_block.modal.control = ControlMode::Continuous;  // G64
+                        mg_word_bit            = ModalGroup::MG13;
                         break;
                     default:
                         FAIL(Error::GcodeUnsupportedCommand);  // [Unsupported G command]
@@ -942,7 +946,20 @@ Error gc_execute_line(char* line) {
             coords[gc_block.modal.coord_select]->get(block_coord_system);
         }
     }
-    // [16. Set path control mode ]: N/A. Only G61. G61.1 and G64 NOT SUPPORTED.
+    // [16. Set path control mode ]: G64 takes an optional P blending tolerance. G61.1 NOT SUPPORTED.
+    bool path_tolerance_given = false;
+    if (bitnum_is_true(command_words, ModalGroup::MG13) && gc_block.modal.control == ControlMode::Continuous) {
+        if (bitnum_is_true(value_words, GCodeWord::P)) {
+            if (gc_block.values.p < 0.0f) {
+                FAIL(Error::NegativeValue);  // [G64 P tolerance cannot be negative]
+            }
+            if (gc_block.modal.units == Units::Inches) {
+                gc_block.values.p *= MM_PER_INCH;
+            }
+            path_tolerance_given = true;
+            clear_bitnum(value_words, GCodeWord::P);
+        }
+    }
     // [17. Set distance mode ]: N/A. Only G91.1. G90.1 NOT SUPPORTED.
     // [18. Set retract mode ]: NOT SUPPORTED.
     // [19. Remaining non-modal actions ]: Check go to predefined position, set G10, or set axis offsets.
@@ -1539,8 +1556,11 @@ Error gc_execute_line(char* line) {
         copyAxes(gc_state.coord_system, block_coord_system);
         gc_wco_changed();
     }
-    // [16. Set path control mode ]: G61.1/G64 NOT SUPPORTED
-    // gc_state.modal.control = gc_block.modal.control; // NOTE: Always default.
+    // [16. Set path control mode ]: G61.1 NOT SUPPORTED
+    gc_state.modal.control = gc_block.modal.control;
+    if (bitnum_is_true(command_words, ModalGroup::MG13) && gc_state.modal.control == ControlMode::Continuous) {
+        gc_state.path_tolerance = path_tolerance_given ? gc_block.values.p : 0.0f;
+    }
     // [17. Set distance mode ]:
     gc_state.modal.distance = gc_block.modal.distance;
     // [18. Set retract mode ]: NOT SUPPORTED
@@ -1594,7 +1614,11 @@ Error gc_execute_line(char* line) {
         if (axis_command == AxisCommand::MotionMode) {
             GCUpdatePos gc_update_pos = GCUpdatePos::Target;
             if (gc_state.modal.motion == Motion::Linear) {
-                mc_linear(gc_block.values.xyz, pl_data, gc_state.position);
+                if (gc_state.modal.control == ControlMode::Continuous) {
+                    mc_linear_blended(gc_block.values.xyz, pl_data, gc_state.position, gc_state.path_tolerance);
+                } else {
+                    mc_linear(gc_block.values.xyz, pl_data, gc_state.position);
+                }
             } else if (gc_state.modal.motion == Motion::Seek) {
                 pl_data->motion.rapidMotion = 1;  // Set rapid motion flag.
                 mc_linear(gc_block.values.xyz, pl_data, gc_state.position);
@@ -1678,6 +1702,7 @@ Error gc_execute_line(char* line) {
                 sys.r_override        = RapidOverride::Default;
                 sys.spindle_speed_ovr = SpindleSpeedOverride::Default;
             }
+            sys.underrun_scale = UnderrunScale::Default;
 
             // Execute coordinate change and spindle/coolant stop.
             if (!state_is(State::CheckMode)) {
@@ -1719,7 +1744,7 @@ Error gc_execute_line(char* line) {
    group 8 = {M7*} enable mist coolant (* Compile-option)
    group 9 = {M48, M49} enable/disable feed and speed override switches
    group 10 = {G98, G99} return mode canned cycles
-   group 13 = {G61.1, G64} path control mode (G61 is supported)
+   group 13 = {G61.1} path control mode (G61 and G64 are supported)
 */
 
 void WEAK_LINK user_m30() {}
@@ -79,22 +79,28 @@ static std::atomic<std::uint32_t> i2s_out_port_data = ATOMIC_VAR_INIT(0);
 //
 // Configrations for DMA connected I2S
 //
-// One DMA buffer transfer takes about 2 ms
-//   I2S_OUT_DMABUF_LEN / I2S_SAMPLE_SIZE x I2S_OUT_USEC_PER_PULSE
+// One DMA buffer transfer takes about 2 ms with the default i2so/dma_buffer_bytes
+//   dmabuf_len / I2S_SAMPLE_SIZE x I2S_OUT_USEC_PER_PULSE
 //   = 2000 / 4 x 4
 //   = 2000us = 2ms
-// If I2S_OUT_DMABUF_COUNT is 5, it will take about 10 ms for all the DMA buffer transfers to finish.
+// If i2so/dma_buffers is 5, it will take about 10 ms for all the DMA buffer transfers to finish.
 //
-// Increasing I2S_OUT_DMABUF_COUNT has the effect of preventing buffer underflow,
+// Increasing the number of buffers has the effect of preventing buffer underflow,
 // but on the other hand, it leads to a delay with pulse and/or non-pulse-generated I/Os.
-// The number of I2S_OUT_DMABUF_COUNT should be chosen carefully.
+// Both are configurable so that each machine can choose: lasers want a short delay to keep
+// PWM in step with motion, routers want more immunity to jitter.
 //
 // Reference information:
 //   FreeRTOS task time slice = portTICK_PERIOD_MS = 1 ms (ESP32 FreeRTOS port)
 //
-const int I2S_SAMPLE_SIZE   = 4;                                    /* 4 bytes, 32 bits per sample */
-const int DMA_SAMPLE_COUNT  = I2S_OUT_DMABUF_LEN / I2S_SAMPLE_SIZE; /* number of samples per buffer */
-const int SAMPLE_SAFE_COUNT = (20 / I2S_OUT_USEC_PER_PULSE);        /* prevent buffer overrun ($0 should be less than or equal 20) */
+const int I2S_SAMPLE_SIZE   = 4;                              /* 4 bytes, 32 bits per sample */
+const int SAMPLE_SAFE_COUNT = (20 / I2S_OUT_USEC_PER_PULSE);  /* prevent buffer overrun ($0 should be less than or equal 20) */
+
+static int i2s_out_dmabuf_count;     /* number of DMA buffers to store data */
+static int i2s_out_dmabuf_len;       /* size of each buffer in bytes */
+static int dma_sample_count;         /* number of samples per buffer */
+static int i2s_out_delay_dmabuf_ms;  /* time to transfer one buffer, at least 1 ms */
+static int i2s_out_delay_ms;         /* time for data to pass through all of the buffers */
 
 typedef struct {
     uint32_t**   buffers;
@@ -198,26 +204,26 @@ static inline void i2s_out_reset_fifo_without_lock() {
 
 static int i2s_clear_dma_buffer(lldesc_t* dma_desc, uint32_t port_data) {
     uint32_t* buf = (uint32_t*)dma_desc->buf;
-    for (int i = 0; i < DMA_SAMPLE_COUNT; i++) {
+    for (int i = 0; i < dma_sample_count; i++) {
         buf[i] = port_data;
     }
     // Restore the buffer length.
     // The length may have been changed short when the data was filled in to prevent buffer overrun.
-    dma_desc->length = I2S_OUT_DMABUF_LEN;
+    dma_desc->length = i2s_out_dmabuf_len;
     return 0;
 }
 
 static int i2s_clear_o_dma_buffers(uint32_t port_data) {
-    for (int buf_idx = 0; buf_idx < I2S_OUT_DMABUF_COUNT; buf_idx++) {
+    for (int buf_idx = 0; buf_idx < i2s_out_dmabuf_count; buf_idx++) {
         // Initialize DMA descriptor
         o_dma.desc[buf_idx]->owner        = 1;
         o_dma.desc[buf_idx]->eof          = 1;  // set to 1 will trigger the interrupt
         o_dma.desc[buf_idx]->sosf         = 0;
-        o_dma.desc[buf_idx]->length       = I2S_OUT_DMABUF_LEN;
-        o_dma.desc[buf_idx]->size         = I2S_OUT_DMABUF_LEN;
+        o_dma.desc[buf_idx]->length       = i2s_out_dmabuf_len;
+        o_dma.desc[buf_idx]->size         = i2s_out_dmabuf_len;
         o_dma.desc[buf_idx]->buf          = (uint8_t*)o_dma.buffers[buf_idx];
         o_dma.desc[buf_idx]->offset       = 0;
-        o_dma.desc[buf_idx]->qe.stqe_next = (lldesc_t*)((buf_idx < (I2S_OUT_DMABUF_COUNT - 1)) ? (o_dma.desc[buf_idx + 1]) : o_dma.desc[0]);
+        o_dma.desc[buf_idx]->qe.stqe_next = (lldesc_t*)((buf_idx < (i2s_out_dmabuf_count - 1)) ? (o_dma.desc[buf_idx + 1]) : o_dma.desc[0]);
         i2s_clear_dma_buffer(o_dma.desc[buf_idx], port_data);
     }
     return 0;
@@ -363,7 +369,7 @@ static int i2s_fillout_dma_buffer(lldesc_t* dma_desc) {
         // and the pulse generation is postponed until the next buffer is filled.
         //
         o_dma.rw_pos = 0;
-        while (o_dma.rw_pos < (DMA_SAMPLE_COUNT - SAMPLE_SAFE_COUNT)) {
+        while (o_dma.rw_pos < (dma_sample_count - SAMPLE_SAFE_COUNT)) {
             // no data to read (buffer empty)
             if (i2s_out_remain_time_until_next_pulse < I2S_OUT_USEC_PER_PULSE) {
                 // pulser status may change in pulse phase func, so I need to check it every time.
@@ -387,17 +393,30 @@ static int i2s_fillout_dma_buffer(lldesc_t* dma_desc) {
                         // To prevent the pulse function from being called back,
                         // we assume that the buffer is already full.
                         i2s_out_remain_time_until_next_pulse = 0;                 // There is no need to fill the current buffer.
-                        o_dma.rw_pos                         = DMA_SAMPLE_COUNT;  // The buffer is full.
+                        o_dma.rw_pos                         = dma_sample_count;  // The buffer is full.
                         break;
                     }
                     continue;
                 }
             }
             // no pulse data in push buffer (pulse off or idle or callback is not defined)
-            buf[o_dma.rw_pos++] = ATOMIC_LOAD(&i2s_out_port_data);
+            // Fill the time until the next pulse, or the rest of the buffer, as one run of
+            // the current port data instead of one sample per pass through the loop.
+            uint32_t space = (dma_sample_count - SAMPLE_SAFE_COUNT) - o_dma.rw_pos;
+            uint32_t run   = i2s_out_remain_time_until_next_pulse / I2S_OUT_USEC_PER_PULSE;
+            if (run == 0 || run > space) {
+                run = space;
+            }
             if (i2s_out_remain_time_until_next_pulse >= I2S_OUT_USEC_PER_PULSE) {
-                i2s_out_remain_time_until_next_pulse -= I2S_OUT_USEC_PER_PULSE;
+                i2s_out_remain_time_until_next_pulse -= run * I2S_OUT_USEC_PER_PULSE;
+            }
+            uint32_t  port_data = ATOMIC_LOAD(&i2s_out_port_data);
+            uint32_t* sample    = &buf[o_dma.rw_pos];
+            uint32_t* end       = sample + run;
+            while (sample < end) {
+                *sample++ = port_data;
             }
+            o_dma.rw_pos += run;
         }
         // set filled length to the DMA descriptor
         dma_desc->length = o_dma.rw_pos * I2S_SAMPLE_SIZE;
@@ -454,11 +473,11 @@ static void IRAM_ATTR i2s_out_intr_handler(void* arg) {
             // lldesc_t.buf is const for S2.  Perhaps we can get by
             // without replacing the data in the buffer since we are
             // already in an error situation.
-            for (int i = 0; i < DMA_SAMPLE_COUNT; i++) {
+            for (int i = 0; i < dma_sample_count; i++) {
                 front_desc->buf[i] = port_data;
             }
 #    endif
-            front_desc->length = I2S_OUT_DMABUF_LEN;
+            front_desc->length = i2s_out_dmabuf_len;
         }
 
         // Send a DMA complete event to the I2S bitstreamer task with finished buffer
@@ -544,7 +563,7 @@ void i2s_out_delay() {
         // Just wait until the data now registered in the DMA descripter
         // is reflected in the I2S TX module via FIFO.
         // XXX perhaps just wait until I2SO.conf1.tx_start == 0
-        delay_ms(I2S_OUT_DELAY_MS);
+        delay_ms(i2s_out_delay_ms);
     }
     I2S_OUT_PULSER_EXIT_CRITICAL();
 }
@@ -614,7 +633,7 @@ int i2s_out_set_stepping() {
         // Wait for complete DMAs
         for (;;) {
             I2S_OUT_PULSER_EXIT_CRITICAL();
-            delay_ms(I2S_OUT_DELAY_DMABUF_MS);
+            delay_ms(i2s_out_delay_dmabuf_ms);
             I2S_OUT_PULSER_ENTER_CRITICAL();
             if (i2s_out_pulser_status == WAITING) {
                 continue;
@@ -677,6 +696,15 @@ int i2s_out_init(i2s_out_init_t& init_param) {
 
     ATOMIC_STORE(&i2s_out_port_data, init_param.init_val);
 
+    i2s_out_dmabuf_count    = init_param.dmabuf_count;
+    i2s_out_dmabuf_len      = init_param.dmabuf_len;
+    dma_sample_count        = i2s_out_dmabuf_len / I2S_SAMPLE_SIZE;
+    i2s_out_delay_dmabuf_ms = dma_sample_count * I2S_OUT_USEC_PER_PULSE / 1000;
+    if (i2s_out_delay_dmabuf_ms < 1) {
+        i2s_out_delay_dmabuf_ms = 1;
+    }
+    i2s_out_delay_ms = (i2s_out_latency_usecs(i2s_out_dmabuf_count, i2s_out_dmabuf_len) + 999) / 1000;
+
     // To make sure hardware is enabled before any hardware register operations.
     periph_module_reset(PERIPH_I2S0_MODULE);
     periph_module_enable(PERIPH_I2S0_MODULE);
@@ -710,27 +738,27 @@ int i2s_out_init(i2s_out_init_t& init_param) {
    */
 
     // Allocate the array of pointers to the buffers
-    o_dma.buffers = (uint32_t**)malloc(sizeof(uint32_t*) * I2S_OUT_DMABUF_COUNT);
+    o_dma.buffers = (uint32_t**)malloc(sizeof(uint32_t*) * i2s_out_dmabuf_count);
     if (o_dma.buffers == nullptr) {
         return -1;
     }
 
     // Allocate each buffer that can be used by the DMA controller
-    for (int buf_idx = 0; buf_idx < I2S_OUT_DMABUF_COUNT; buf_idx++) {
-        o_dma.buffers[buf_idx] = (uint32_t*)heap_caps_calloc(1, I2S_OUT_DMABUF_LEN, MALLOC_CAP_DMA);
+    for (int buf_idx = 0; buf_idx < i2s_out_dmabuf_count; buf_idx++) {
+        o_dma.buffers[buf_idx] = (uint32_t*)heap_caps_calloc(1, i2s_out_dmabuf_len, MALLOC_CAP_DMA);
         if (o_dma.buffers[buf_idx] == nullptr) {
             return -1;
         }
     }
 
     // Allocate the array of DMA descriptors
-    o_dma.desc = (lldesc_t**)malloc(sizeof(lldesc_t*) * I2S_OUT_DMABUF_COUNT);
+    o_dma.desc = (lldesc_t**)malloc(sizeof(lldesc_t*) * i2s_out_dmabuf_count);
     if (o_dma.desc == nullptr) {
         return -1;
     }
 
     // Allocate each DMA descriptor that will be used by the DMA controller
-    for (int buf_idx = 0; buf_idx < I2S_OUT_DMABUF_COUNT; buf_idx++) {
+    for (int buf_idx = 0; buf_idx < i2s_out_dmabuf_count; buf_idx++) {
         o_dma.desc[buf_idx] = (lldesc_t*)heap_caps_malloc(sizeof(lldesc_t), MALLOC_CAP_DMA);
         if (o_dma.desc[buf_idx] == nullptr) {
             return -1;
@@ -741,7 +769,7 @@ int i2s_out_init(i2s_out_init_t& init_param) {
     i2s_clear_o_dma_buffers(init_param.init_val);
     o_dma.rw_pos  = 0;
     o_dma.current = NULL;
-    o_dma.queue   = xQueueCreate(I2S_OUT_DMABUF_COUNT, sizeof(uint32_t*));
+    o_dma.queue   = xQueueCreate(i2s_out_dmabuf_count, sizeof(uint32_t*));
 
     // Set the first DMA descriptor
     I2S0.out_link.addr = (uint32_t)o_dma.desc[0];
@@ -943,6 +971,8 @@ int i2s_out_init() {
         default_param.data_pin     = dataPin.getNative(Pin::Capabilities::Output | Pin::Capabilities::Native);
         default_param.pulse_period = I2S_OUT_USEC_PER_PULSE;
         default_param.init_val     = I2S_OUT_INIT_VAL;
+        default_param.dmabuf_count = i2so->_dmaBufCount;
+        default_param.dmabuf_len   = i2so->_dmaBufLen;
 
         return i2s_out_init(default_param);
     }
@@ -31,11 +31,20 @@ const uint32_t I2S_STREAM_MAX_USEC_PER_PULSE = 20;
 
 constexpr uint32_t i2s_out_max_steps_per_sec = 1000000 / (2 * I2S_OUT_USEC_PER_PULSE);
 
+// Defaults for i2so/dma_buffers and i2so/dma_buffer_bytes
 const int I2S_OUT_DMABUF_COUNT = 5;    /* number of DMA buffers to store data */
 const int I2S_OUT_DMABUF_LEN   = 2000; /* maximum size in bytes (4092 is DMA's limit) */
 
-const int I2S_OUT_DELAY_DMABUF_MS = (I2S_OUT_DMABUF_LEN / sizeof(uint32_t) * I2S_OUT_USEC_PER_PULSE / 1000);
-const int I2S_OUT_DELAY_MS        = (I2S_OUT_DELAY_DMABUF_MS * (I2S_OUT_DMABUF_COUNT + 1));
+const int I2S_OUT_DMABUF_COUNT_MIN = 2;
+const int I2S_OUT_DMABUF_COUNT_MAX = 16;
+const int I2S_OUT_DMABUF_LEN_MIN   = 200;
+const int I2S_OUT_DMABUF_LEN_MAX   = 4092;
+
+// Time for a change to the port data to reach the pins while streaming, in microseconds.
+// Every DMA buffer may be queued ahead of it, plus the one being filled.
+inline uint32_t i2s_out_latency_usecs(int dmabuf_count, int dmabuf_len) {
+    return uint32_t(dmabuf_len) / sizeof(uint32_t) * I2S_OUT_USEC_PER_PULSE * (dmabuf_count + 1);
+}
 
 typedef struct {
     /*
@@ -56,6 +65,8 @@ typedef struct {
     pinnum_t data_pin;
     uint32_t pulse_period;  // aka step rate.
     uint32_t init_val;
+    int      dmabuf_count;  // Number of DMA buffers
+    int      dmabuf_len;    // Bytes per DMA buffer, a multiple of 4
 } i2s_out_init_t;
 
 /*
@@ -0,0 +1,115 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  InputShaper.h - zero-vibration input shapers applied to the speed ramps of the segment generator.
+
+  A shaper is a short train of impulses whose amplitudes sum to one.  Convolving a commanded
+  acceleration with it cancels the residual vibration of a resonance at the shaper frequency.
+  Only undamped shapers are used; their impulse trains are symmetric in time, which is what lets
+  a shaped ramp keep the duration and distance of the constant-acceleration ramp it replaces.
+*/
+
+#include <algorithm>
+
+struct InputShaper {
+    enum Type {
+        None = 0,
+        ZV,   // Zero Vibration: 2 impulses, half a period long
+        ZVD,  // Zero Vibration and Derivative: 3 impulses, one period long, more robust
+        EI,   // Extra Insensitive, 5% vibration tolerance: 3 impulses, one period long, most robust
+    };
+
+    static const int max_impulses = 3;
+
+    int   n_impulses = 0;
+    float amplitude[max_impulses];
+    float delay[max_impulses];
+
+    // Sets up a shaper for a resonance with the given period, in the time unit of the caller.
+    void set(int type, float period) {
+        const float v = 0.05f;  // EI vibration tolerance
+        switch (type) {
+            case ZV:
+                n_impulses = 2;
+                set_impulse(0, 0.5f, 0.0f);
+                set_impulse(1, 0.5f, 0.5f * period);
+                break;
+            case ZVD:
+                n_impulses = 3;
+                set_impulse(0, 0.25f, 0.0f);
+                set_impulse(1, 0.5f, 0.5f * period);
+                set_impulse(2, 0.25f, period);
+                break;
+            case EI:
+                n_impulses = 3;
+                set_impulse(0, 0.25f * (1 + v), 0.0f);
+                set_impulse(1, 0.5f * (1 - v), 0.5f * period);
+                set_impulse(2, 0.25f * (1 + v), period);
+                break;
+            default:
+                n_impulses = 0;
+                break;
+        }
+    }
+
+    // Time from the first impulse to the last
+    float duration() const { return n_impulses ? delay[n_impulses - 1] : 0.0f; }
+
+private:
+    void set_impulse(int i, float a, float t) {
+        amplitude[i] = a;
+        delay[i]     = t;
+    }
+};
+
+// A speed ramp from start_speed by delta_speed over duration, whose constant acceleration has been
+// convolved with a shaper.  The unshaped base ramp is shorter than duration by the length of the
+// shaper, so the shaped ramp ends on time at the target speed.  Because the impulse train is
+// symmetric, the distance covered is also that of a constant-acceleration ramp of full duration.
+// The peak acceleration rises by duration / (duration - shaper length) to pay for that, which
+// fits() bounds by peak_ratio.  The planner divides the acceleration of blocks whose dominant
+// axis has a shaper by peak_ratio, so the peak stays within the axis limits.
+struct ShapedRamp {
+    const InputShaper* shaper;
+    float              start_speed;
+    float              delta_speed;
+    float              duration;
+
+    // A ramp can only be shaped if it lasts at least min_ramp times as long as the shaper, so
+    // its peak acceleration is at most peak_ratio times the average.
+    static constexpr float min_ramp   = 4.0f;
+    static constexpr float peak_ratio = min_ramp / (min_ramp - 1.0f);
+
+    static bool fits(const InputShaper& shaper, float duration) {
+        return shaper.n_impulses && duration >= min_ramp * shaper.duration();
+    }
+
+    float base() const { return duration - shaper->duration(); }
+
+    // Speed at time t into the ramp
+    float speed(float t) const {
+        float tb   = base();
+        float ramp = 0.0f;
+        for (int i = 0; i < shaper->n_impulses; i++) {
+            ramp += shaper->amplitude[i] * std::min(std::max(t - shaper->delay[i], 0.0f), tb);
+        }
+        return start_speed + delta_speed * ramp / tb;
+    }
+
+    // Distance covered from the start of the ramp to time t
+    float distance(float t) const {
+        float tb   = base();
+        float ramp = 0.0f;
+        for (int i = 0; i < shaper->n_impulses; i++) {
+            float u = t - shaper->delay[i];
+            if (u > tb) {
+                ramp += shaper->amplitude[i] * tb * (u - 0.5f * tb);
+            } else if (u > 0.0f) {
+                ramp += shaper->amplitude[i] * 0.5f * u * u;
+            }
+        }
+        return start_speed * t + delta_speed * ramp / tb;
+    }
+};
@@ -12,13 +12,6 @@
 #include "Kinematics.h"
 #include "Cartesian.h"
 
-// M_PI is not defined in standard C/C++ but some compilers
-// support it anyway.  The following suppresses Intellisense
-// problem reports.
-#ifndef M_PI
-#    define M_PI 3.14159265358979323846
-#endif
-
 namespace Kinematics {
 
     class ParallelDelta : public Cartesian {
@@ -7,6 +7,9 @@
 #include "../Stepper.h"     // stepper_id_t
 #include "MachineConfig.h"  // config->
 #include "../Limits.h"
+#include "Driver/fluidnc_gpio.h"  // gpio_write_mask
+
+#include <algorithm>
 
 const EnumItem axisType[] = { { 0, "X" }, { 1, "Y" }, { 2, "Z" }, { 3, "A" }, { 4, "B" }, { 5, "C" }, EnumItem(0) };
 
@@ -41,11 +44,38 @@ namespace Machine {
         }
 
         // certain motors need features to be turned on. Check them here
+        _numberStepMotors = 0;
+        _unstepSetMask    = 0;
+        _unstepClearMask  = 0;
         for (size_t axis = X_AXIS; axis < _numberAxis; axis++) {
-            auto a = _axis[axis];
+            auto a          = _axis[axis];
+            _burstMax[axis] = 0;
             if (a) {
                 log_info("Axis " << axisName(axis) << " (" << limitsMinPosition(axis) << "," << limitsMaxPosition(axis) << ")");
                 a->init();
+                uint32_t burstMax = UINT32_MAX;
+                for (size_t motor = 0; motor < Axis::MAX_MOTORS_PER_AXIS; motor++) {
+                    auto m = a->_motors[motor];
+                    if (m) {
+                        burstMax = std::min(burstMax, m->_driver->step_burst_max());
+                        pinnum_t gpio;
+                        bool     activeLow = false;
+                        uint64_t pin       = m->_driver->direct_step_pin(gpio, activeLow) ? 1ULL << gpio : 0;
+                        if (activeLow) {
+                            _unstepSetMask |= pin;
+                        } else {
+                            _unstepClearMask |= pin;
+                        }
+                        _stepMotors[_numberStepMotors]         = m;
+                        _stepMotorAxis[_numberStepMotors]      = axis;
+                        _stepMotorPins[_numberStepMotors]      = pin;
+                        _stepMotorActiveLow[_numberStepMotors] = activeLow;
+                        _numberStepMotors++;
+                    }
+                }
+                if (burstMax != UINT32_MAX) {
+                    _burstMax[axis] = burstMax;
+                }
             }
         }
 
@@ -103,58 +133,87 @@ namespace Machine {
         return motorsCanHome;
     }
 
-    void IRAM_ATTR Axes::step(uint8_t step_mask, uint8_t dir_mask) {
-        auto n_axis = _numberAxis;
-        //log_info("motors_set_direction_pins:0x%02X", onMask);
-
-        // Set the direction pins, but optimize for the common
-        // situation where the direction bits haven't changed.
+    // Set the direction pins, but optimize for the common
+    // situation where the direction bits haven't changed.
+    void IRAM_ATTR Axes::set_direction(uint8_t dir_mask) {
         static uint8_t previous_dir = 255;  // should never be this value
         if (dir_mask != previous_dir) {
             previous_dir = dir_mask;
 
-            for (int axis = X_AXIS; axis < n_axis; axis++) {
-                bool thisDir = bitnum_is_true(dir_mask, axis);
-
-                for (size_t motor = 0; motor < Axis::MAX_MOTORS_PER_AXIS; motor++) {
-                    auto m = _axis[axis]->_motors[motor];
-                    if (m) {
-                        m->_driver->set_direction(thisDir);
-                    }
-                }
+            auto n_motors = _numberStepMotors;
+            for (int i = 0; i < n_motors; i++) {
+                _stepMotors[i]->_driver->set_direction(bitnum_is_true(dir_mask, _stepMotorAxis[i]));
             }
             config->_stepping->waitDirection();
         }
+    }
 
-        // Turn on step pulses for motors that are supposed to step now
-        for (size_t axis = X_AXIS; axis < n_axis; axis++) {
-            if (bitnum_is_true(step_mask, axis)) {
-                bool dir = bitnum_is_true(dir_mask, axis);
+    void IRAM_ATTR Axes::step(uint8_t step_mask, uint8_t dir_mask) {
+        auto n_motors = _numberStepMotors;
+        //log_info("motors_set_direction_pins:0x%02X", onMask);
 
-                auto a = _axis[axis];
-                for (size_t motor = 0; motor < Axis::MAX_MOTORS_PER_AXIS; motor++) {
-                    auto m = a->_motors[motor];
-                    if (m) {
+        set_direction(dir_mask);
+
+        // Turn on step pulses for motors that are supposed to step now
+        if (step_mask) {
+            uint64_t setMask   = 0;
+            uint64_t clearMask = 0;
+            for (int i = 0; i < n_motors; i++) {
+                auto axis = _stepMotorAxis[i];
+                if (bitnum_is_true(step_mask, axis)) {
+                    auto m   = _stepMotors[i];
+                    bool dir = bitnum_is_true(dir_mask, axis);
+                    auto pin = _stepMotorPins[i];
+                    if (!pin) {
                         m->step(dir);
+                    } else if (m->take_step(dir)) {
+                        if (_stepMotorActiveLow[i]) {
+                            clearMask |= pin;
+                        } else {
+                            setMask |= pin;
+                        }
                     }
                 }
             }
+            if (setMask | clearMask) {
+                gpio_write_mask(setMask, clearMask);
+            }
         }
         config->_stepping->startPulseTimer();
     }
 
+    // Hand a train of steps to every motor of the axis; see MotorDriver::step_burst()
+    void IRAM_ATTR Axes::step_burst(size_t axis, const uint32_t* times, uint32_t count, bool reverse) {
+        auto a = _axis[axis];
+        for (size_t motor = 0; motor < Axis::MAX_MOTORS_PER_AXIS; motor++) {
+            auto m = a->_motors[motor];
+            if (m && m->take_steps(reverse, count)) {
+                m->_driver->step_burst(times, count);
+            }
+        }
+    }
+
+    // End any step trains that are still running.  Their steps were counted when they were
+    // started, so positions are lost, as they are whenever motion stops abruptly.
+    void IRAM_ATTR Axes::stop_bursts() {
+        auto n_motors = _numberStepMotors;
+        for (int i = 0; i < n_motors; i++) {
+            _stepMotors[i]->_driver->stop_burst();
+        }
+    }
+
     // Turn all stepper pins off
     void IRAM_ATTR Axes::unstep() {
         config->_stepping->waitPulse();
-        auto n_axis = _numberAxis;
-        for (size_t axis = X_AXIS; axis < n_axis; axis++) {
-            for (size_t motor = 0; motor < Axis::MAX_MOTORS_PER_AXIS; motor++) {
-                auto m = _axis[axis]->_motors[motor];
-                if (m) {
-                    m->_driver->unstep();
-                }
+        auto n_motors = _numberStepMotors;
+        for (int i = 0; i < n_motors; i++) {
+            if (!_stepMotorPins[i]) {
+                _stepMotors[i]->_driver->unstep();
             }
         }
+        if (_unstepSetMask | _unstepClearMask) {
+            gpio_write_mask(_unstepSetMask, _unstepClearMask);
+        }
 
         config->_stepping->finishPulse();
     }
@@ -289,8 +348,8 @@ namespace Machine {
         bool retval = true;
         const auto lenNames = strlen(names);
         for (int i = 0; i < lenNames; i++) {
-            char  axisName = toupper(names[i]);
-            char* pos      = index(_names, axisName);
+            char        axisName = toupper(names[i]);
+            const char* pos      = strchr(_names, axisName);
             if (!pos) {
                 log_error("Invalid axis name " << names[i]);
                 retval = false;
@@ -45,6 +45,24 @@ namespace Machine {
         int   _numberAxis = 0;
         Axis* _axis[MAX_N_AXIS];
 
+        // Every motor of every axis in one list, built by init(), so that step() and unstep()
+        // walk only the motors that exist.
+        static const int MAX_STEP_MOTORS = MAX_N_AXIS * Axis::MAX_MOTORS_PER_AXIS;
+
+        int     _numberStepMotors = 0;
+        Motor*  _stepMotors[MAX_STEP_MOTORS];
+        uint8_t _stepMotorAxis[MAX_STEP_MOTORS];
+
+        // Motors whose step pins are written directly have their GPIO bit in _stepMotorPins and
+        // are stepped together in one write per GPIO bank.  The masks turn the pins back off.
+        uint64_t _stepMotorPins[MAX_STEP_MOTORS];
+        bool     _stepMotorActiveLow[MAX_STEP_MOTORS];
+        uint64_t _unstepSetMask   = 0;
+        uint64_t _unstepClearMask = 0;
+
+        // The most steps every motor of the axis can take in one step_burst(), 0 if not all can
+        uint32_t _burstMax[MAX_N_AXIS] = { 0 };
+
         // Some small helpers to find the axis index and axis motor number for a given motor. This
         // is helpful for some motors that need this info, as well as debug information.
         size_t findAxisIndex(const MotorDrivers::MotorDriver* const motor) const;
@@ -74,7 +92,10 @@ namespace Machine {
 
         void set_disable(int axis, bool disable);
         void set_disable(bool disable);
+        void set_direction(uint8_t dir_mask);
         void step(uint8_t step_mask, uint8_t dir_mask);
+        void step_burst(size_t axis, const uint32_t* times, uint32_t count, bool reverse);
+        void stop_bursts();
         void unstep();
         void config_motors();
 
@@ -4,6 +4,12 @@
 
 #include <cstring>
 
+const EnumItem shaperTypes[] = { { InputShaper::None, "None" },
+                                 { InputShaper::ZV, "ZV" },
+                                 { InputShaper::ZVD, "ZVD" },
+                                 { InputShaper::EI, "EI" },
+                                 EnumItem(InputShaper::None) };
+
 namespace Machine {
     void Axis::group(Configuration::HandlerBase& handler) {
         handler.item("steps_per_mm", _stepsPerMm, 0.001, 100000.0);
@@ -11,6 +17,10 @@ namespace Machine {
         handler.item("acceleration_mm_per_sec2", _acceleration, 0.001, 100000.0);
         handler.item("max_travel_mm", _maxTravel, 0.1, 10000000.0);
         handler.item("soft_limits", _softLimits);
+        handler.item("rotary_radius_mm", _rotaryRadius, 0.0, 10000.0);
+        handler.item("junction_jerk_mm_per_min", _junctionJerk, 0.0, 100000.0);
+        handler.item("shaper_type", _shaperType, shaperTypes);
+        handler.item("shaper_frequency_hz", _shaperFrequency, 1.0, 500.0);
         handler.section("homing", _homing);
 
         char tmp[7];
@@ -34,6 +44,7 @@ namespace Machine {
         if (_motors[0] == nullptr) {
             _motors[0] = new Machine::Motor(_axis, 0);
         }
+        _shaper.set(_shaperType, 1.0f / (_shaperFrequency * 60.0f));
     }
 
     void Axis::init() {
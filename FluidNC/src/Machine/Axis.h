@@ -8,6 +8,8 @@
 // #include "Axes.h"
 #include "Motor.h"
 #include "Homing.h"
+#include "../InputShaper.h"
+#include "../EnumItem.h"
 
 namespace MotorDrivers {
     class MotorDriver;
@@ -36,6 +38,25 @@ namespace Machine {
         float _maxTravel    = 1000.0f;
         bool  _softLimits   = false;
 
+        // Non-zero makes this a rotary axis, moved in degrees.  Programmed feed rates then
+        // apply to the tool tip at this distance from the rotation center.
+        float _rotaryRadius = 0.0f;
+
+        // Largest abrupt change of this axis's speed allowed at a junction, in mm/min.
+        // Zero leaves junction speeds to junction_deviation_mm alone.
+        float _junctionJerk = 0.0f;
+
+        // Input shaper for the speed ramps of moves dominated by this axis, tuned to the
+        // resonance of this axis at _shaperFrequency in Hz.  Only the acceleration and
+        // deceleration ramps within a block are shaped, and only those lasting at least
+        // ShapedRamp::min_ramp times the shaper duration; the speed change at a junction
+        // is not.  Such moves are planned with the acceleration limit divided by
+        // ShapedRamp::peak_ratio, which shaping raises back to at most the limit.
+        int   _shaperType      = InputShaper::None;
+        float _shaperFrequency = 40.0f;
+
+        InputShaper _shaper;  // Derived from the above, with delays in minutes
+
         // Configuration system helpers:
         void group(Configuration::HandlerBase& handler) override;
         void afterParse() override;
@@ -53,3 +74,4 @@ namespace Machine {
         ~Axis();
     };
 }
+extern const EnumItem shaperTypes[];
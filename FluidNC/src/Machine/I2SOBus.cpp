@@ -12,16 +12,20 @@ namespace Machine {
             Assert(_data.defined(), "I2SO Data pin should be configured once");
             Assert(_ws.defined(), "I2SO WS pin should be configured once");
         }
+        Assert(_dmaBufLen % 4 == 0, "I2SO dma_buffer_bytes must be a multiple of 4");
     }
 
     void I2SOBus::group(Configuration::HandlerBase& handler) {
         handler.item("bck_pin", _bck);
         handler.item("data_pin", _data);
         handler.item("ws_pin", _ws);
+        handler.item("dma_buffers", _dmaBufCount, I2S_OUT_DMABUF_COUNT_MIN, I2S_OUT_DMABUF_COUNT_MAX);
+        handler.item("dma_buffer_bytes", _dmaBufLen, I2S_OUT_DMABUF_LEN_MIN, I2S_OUT_DMABUF_LEN_MAX);
     }
 
     void I2SOBus::init() {
-        log_info("I2SO BCK:" << _bck.name() << " WS:" << _ws.name() << " DATA:" << _data.name());
+        log_info("I2SO BCK:" << _bck.name() << " WS:" << _ws.name() << " DATA:" << _data.name() << " DMA:" << _dmaBufCount << "x"
+                              << _dmaBufLen << " Latency:" << i2s_out_latency_usecs(_dmaBufCount, _dmaBufLen) << "us");
         i2s_out_init();
     }
 }
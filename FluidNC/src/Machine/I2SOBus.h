@@ -5,6 +5,7 @@
 #pragma once
 
 #include "../Configuration/Configurable.h"
+#include "../I2SOut.h"  // I2S_OUT_DMABUF_COUNT
 
 namespace Machine {
     class I2SOBus : public Configuration::Configurable {
@@ -15,6 +16,11 @@ namespace Machine {
         Pin _data;
         Pin _ws;
 
+        // DMA buffering while streaming steps.  More or longer buffers ride out longer stalls of
+        // the task that fills them, at the cost of a longer delay before I2SO outputs change.
+        int _dmaBufCount = I2S_OUT_DMABUF_COUNT;
+        int _dmaBufLen   = I2S_OUT_DMABUF_LEN;
+
         void validate() override;
         void group(Configuration::HandlerBase& handler) override;
 
@@ -73,11 +73,14 @@ namespace Machine {
         // TODO: Consider putting these under a gcode: hierarchy level? Or motion control?
         handler.item("arc_tolerance_mm", _arcTolerance, 0.001, 1.0);
         handler.item("junction_deviation_mm", _junctionDeviation, 0.01, 1.0);
+        handler.item("smooth_ramps", _smoothRamps);
+        handler.item("segment_merge_tolerance_mm", _segmentMergeTolerance, 0.0, 0.1);
         handler.item("verbose_errors", _verboseErrors);
         handler.item("report_inches", _reportInches);
         handler.item("enable_parking_override_control", _enableParkingOverrideControl);
         handler.item("use_line_numbers", _useLineNumbers);
-        handler.item("planner_blocks", _planner_blocks, 10, 120);
+        handler.item("planner_blocks", _planner_blocks, 10, 1000);
+        handler.item("planner_psram", _plannerPsram);
     }
 
     void MachineConfig::afterParse() {
@@ -81,12 +81,30 @@ namespace Machine {
         UartChannel* _uart_channels[MAX_N_UARTS] = { nullptr };
         Uart*        _uarts[MAX_N_UARTS]         = { nullptr };
 
-        float _arcTolerance      = 0.002f;
-        float _junctionDeviation = 0.01f;
-        bool  _verboseErrors     = true;
-        bool  _reportInches      = false;
-
-        size_t _planner_blocks = 16;
+        float _arcTolerance       = 0.002f;
+        float _junctionDeviation  = 0.01f;
+        bool  _verboseErrors      = true;
+        bool  _reportInches       = false;
+
+        // Shapes each acceleration and deceleration ramp as an S-curve that starts
+        // and ends at zero acceleration, instead of a constant-acceleration line.
+        // This trades ramp time for smoothness and is not a jerk limit: the axis
+        // acceleration limits bound the peak of the curve, so ramps take 1.875
+        // times longer than constant-acceleration ramps, and the peak jerk grows
+        // with the square of the acceleration.  Junction speeds are unchanged.
+        bool _smoothRamps = false;
+
+        // Consecutive feed moves whose joints all lie within this distance of the
+        // straight line through them are merged into one planner block.  Zero disables.
+        // The last move is held back for its successor while the state is still Idle,
+        // so anything that requires Idle first starts it with mc_start_held_motion().
+        float _segmentMergeTolerance = 0.0f;
+
+        uint32_t _planner_blocks = 16;
+
+        // Puts the planner ring in PSRAM, so it can hold many more blocks.  A few
+        // blocks at the executing end are still kept in internal RAM.
+        bool _plannerPsram = false;
 
         // Enables a special set of M-code commands that enables and disables the parking motion.
         // These are controlled by `M56`, `M56 P1`, or `M56 Px` to enable and `M56 P0` to disable.
@@ -5,6 +5,7 @@
 #include "src/Serial.h"                 // Cmd
 #include "src/System.h"                 // sys
 #include "src/Machine/MachineConfig.h"  // config
+#include "src/MotionControl.h"          // mc_start_held_motion
 
 void MacroEvent::run(void* arg) const {
     config->_macros->_macro[_num].run();
@@ -53,6 +54,7 @@ bool Macro::run() {
         return false;
     }
 
+    mc_start_held_motion();
     if (!state_is(State::Idle)) {
         log_error("Macro can only be used in idle state");
         return false;
@@ -71,11 +71,9 @@ namespace Machine {
         // Skip steps based on limit pins
         // _blocked is for asymmetric pulloff
         // _limited is for limit pins
-        if (_blocked || _limited) {
-            return;
+        if (take_step(reverse)) {
+            _driver->step();
         }
-        _driver->step();
-        _steps += reverse ? -1 : 1;
     }
 
     void IRAM_ATTR Motor::unstep() { _driver->unstep(); }
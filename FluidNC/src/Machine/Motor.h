@@ -49,6 +49,22 @@ namespace Machine {
         void init();
         void config_motor();
         void step(bool reverse);
+
+        // Counts a step unless the motor is blocked or limited, returning whether to make it.
+        inline bool take_step(bool reverse) {
+            if (_blocked || _limited) {
+                return false;
+            }
+            _steps += reverse ? -1 : 1;
+            return true;
+        }
+        inline bool take_steps(bool reverse, uint32_t count) {
+            if (_blocked || _limited) {
+                return false;
+            }
+            _steps += reverse ? -int32_t(count) : int32_t(count);
+            return true;
+        }
         void unstep();
         void block() { _blocked = true; }
         void unblock() { _blocked = false; }
@@ -14,22 +14,37 @@
 #include "I2SOut.h"          // i2s_out_reset
 #include "Platform.h"        // WEAK_LINK
 #include "Settings.h"        // coords
+#include "Driver/delay_usecs.h"  // getCpuTicks
 
 #include <cmath>
 
-// M_PI is not defined in standard C/C++ but some compilers
-// support it anyway.  The following suppresses Intellisense
-// problem reports.
-#ifndef M_PI
-#    define M_PI 3.14159265358979323846
-#endif
-
 // mc_pl_data_inflight keeps track of a jog command sent to mc_move_motors() so we can cancel it.
 // this is needed if a jogCancel comes along after we have already parsed a jog and it is in-flight.
 static volatile void* mc_pl_data_inflight;  // holds a plan_line_data_t while mc_move_motors has taken ownership of a line motion
 
+// Most number of programmed segments merged into one planner block.
+static const size_t max_merged_segments = 8;
+
+// G64 corner blending and segment merging hold back the most recent feed segment until the next
+// one arrives, so the corner between them can be replaced by a curve or the two can be joined.
+// Only the tail of the held segment is ever consumed, so blend.start walks forward as corners are
+// resolved.
+static struct {
+    bool             pending;
+    float            start[MAX_N_AXIS];   // Start of the not yet submitted part of the held segment
+    float            target[MAX_N_AXIS];  // Corner point, i.e. end of the held segment
+    plan_line_data_t pl_data;             // Copy of the held segment's plan data
+    int32_t          heldSince;           // CPU ticks when the segment was held
+    size_t           n_joints;            // Programmed endpoints merged into the held segment
+    float            joints[max_merged_segments - 1][MAX_N_AXIS];
+} blend;
+
+// How long a held segment may wait for a successor once the planner is nearly empty.
+static const int32_t blend_hold_us = 20000;
+
 void mc_init() {
     mc_pl_data_inflight = NULL;
+    blend.pending       = false;
 }
 
 // Execute linear motor motion in absolute millimeter coordinates. Feed rate given in
@@ -107,15 +122,238 @@ void mc_cancel_jog() {
 static bool mc_linear_no_check(float* target, plan_line_data_t* pl_data, float* position) {
     return config->_kinematics->cartesian_to_motors(target, pl_data, position);
 }
+
+static void blend_hold(float* target, plan_line_data_t* pl_data, float* start);
+static bool blend_merge(float* target, plan_line_data_t* pl_data, float* position);
+
+// Feed moves can be held back and merged with their successors.  Inverse time feed applies to the
+// programmed segment as a whole, so such moves are passed through unchanged.
+static bool mergeable(plan_line_data_t* pl_data) {
+    return config->_segmentMergeTolerance > 0.0f && !pl_data->motion.rapidMotion && !pl_data->motion.systemMotion &&
+           !pl_data->motion.inverseTime && !pl_data->is_jog;
+}
+
 bool mc_linear(float* target, plan_line_data_t* pl_data, float* position) {
+    if (!mergeable(pl_data)) {
+        mc_flush_blend();
+    }
     if (!pl_data->is_jog && !pl_data->limits_checked) {  // soft limits for jogs have already been dealt with
         if (config->_kinematics->invalid_line(target)) {
             return false;
         }
     }
+    if (mergeable(pl_data)) {
+        if (!blend_merge(target, pl_data, position)) {
+            mc_flush_blend();
+            blend_hold(target, pl_data, position);
+        }
+        return true;
+    }
     return mc_linear_no_check(target, pl_data, position);
 }
 
+// Submit whatever remains of a segment held back for G64 blending or merging.
+void mc_flush_blend() {
+    if (!blend.pending) {
+        return;
+    }
+    blend.pending = false;
+    mc_linear_no_check(blend.target, &blend.pl_data, blend.start);
+}
+
+// Called from the main loop when no line is waiting.  The held segment is released once the planner
+// is about to run dry, otherwise the last segment of a program would wait for a successor forever.
+void mc_blend_idle() {
+    if (!blend.pending || plan_get_block_buffer_available() + 2 < config->_planner_blocks) {
+        return;
+    }
+    if ((getCpuTicks() - blend.heldSince) > usToCpuTicks(blend_hold_us)) {
+        mc_flush_blend();
+    }
+}
+
+// A held motion leaves the state Idle, so commands that check for Idle call this first.  The
+// cycle start takes effect at once, so they then see the state that the motion would have
+// given them without the hold.
+void mc_start_held_motion() {
+    if (!blend.pending) {
+        return;
+    }
+    mc_flush_blend();
+    protocol_auto_cycle_start();
+    protocol_execute_realtime();
+}
+
+static void blend_hold(float* target, plan_line_data_t* pl_data, float* start) {
+    auto n_axis = config->_axes->_numberAxis;
+    for (size_t i = 0; i < n_axis; i++) {
+        blend.start[i]  = start[i];
+        blend.target[i] = target[i];
+    }
+    blend.pl_data   = *pl_data;
+    blend.heldSince = getCpuTicks();
+    blend.n_joints  = 0;
+    blend.pending   = true;
+}
+
+// Extend the held segment to target if the result stays within segment_merge_tolerance_mm of every
+// programmed endpoint it replaces.  Only moves with identical plan data are merged, so feed, spindle
+// and coolant changes still take effect where they were programmed.
+static bool blend_merge(float* target, plan_line_data_t* pl_data, float* position) {
+    if (!blend.pending || config->_segmentMergeTolerance <= 0.0f || blend.n_joints == max_merged_segments - 1) {
+        return false;
+    }
+    auto n_axis = config->_axes->_numberAxis;
+    if (vector_distance(blend.target, position, n_axis) > 1e-6f) {
+        return false;
+    }
+    const plan_line_data_t& held = blend.pl_data;
+    if (held.feed_rate != pl_data->feed_rate || held.spindle_speed != pl_data->spindle_speed || held.spindle != pl_data->spindle ||
+        held.coolant.Flood != pl_data->coolant.Flood || held.coolant.Mist != pl_data->coolant.Mist ||
+        held.motion.noFeedOverride != pl_data->motion.noFeedOverride) {
+        return false;
+    }
+
+    float chord[MAX_N_AXIS];
+    for (size_t i = 0; i < n_axis; i++) {
+        chord[i] = target[i] - blend.start[i];
+    }
+    float length = vector_length(chord, n_axis);
+    if (length < 1e-6f) {
+        return false;
+    }
+    float tolerance_sqr = config->_segmentMergeTolerance * config->_segmentMergeTolerance;
+
+    // Every endpoint must project inside the chord and lie within tolerance of it.
+    for (size_t j = 0; j <= blend.n_joints; j++) {
+        float* joint = j < blend.n_joints ? blend.joints[j] : blend.target;
+        float  along = 0.0f;
+        float  dist2 = 0.0f;
+        for (size_t i = 0; i < n_axis; i++) {
+            float v = joint[i] - blend.start[i];
+            along += v * chord[i];
+            dist2 += v * v;
+        }
+        along /= length;
+        if (along <= 0.0f || along >= length || dist2 - along * along > tolerance_sqr) {
+            return false;
+        }
+    }
+
+    copyAxes(blend.joints[blend.n_joints++], blend.target);
+    copyAxes(blend.target, target);
+    blend.pl_data.line_number = pl_data->line_number;
+    return true;
+}
+
+// Execute a G64 feed motion.  The corner between the held segment S->B and the new one B->C is cut
+// at E = B - L*u1 and X = B + L*u2 and replaced by the quadratic Bezier (E, B, X), which is tangent
+// to both segments.  Its farthest point from B is at t = 1/2, L*sin(theta/2)/2 away, where theta is
+// the turn angle, so L follows from the tolerance.  L is also capped at half of each segment so that
+// consecutive blends never overlap.  The curve is split into chords that stay within arc_tolerance,
+// and the junctions between those chords are gentle enough for the planner to keep feed through them.
+bool mc_linear_blended(float* target, plan_line_data_t* pl_data, float* position, float tolerance) {
+    // Inverse time feed applies to the programmed segment as a whole, so it cannot be split.
+    if (pl_data->motion.rapidMotion || pl_data->motion.systemMotion || pl_data->motion.inverseTime || pl_data->is_jog) {
+        return mc_linear(target, pl_data, position);
+    }
+    if (!pl_data->limits_checked && config->_kinematics->invalid_line(target)) {
+        return false;
+    }
+
+    auto n_axis = config->_axes->_numberAxis;
+    if (!blend.pending || vector_distance(blend.target, position, n_axis) > 1e-6f) {
+        mc_flush_blend();
+        blend_hold(target, pl_data, position);
+        return true;
+    }
+    if (blend_merge(target, pl_data, position)) {
+        return true;
+    }
+
+    float u1[MAX_N_AXIS];
+    float u2[MAX_N_AXIS];
+    float len1      = 0.0f;
+    float len2      = 0.0f;
+    float cos_theta = 0.0f;
+    for (size_t i = 0; i < n_axis; i++) {
+        u1[i] = blend.target[i] - blend.start[i];
+        u2[i] = target[i] - blend.target[i];
+        len1 += u1[i] * u1[i];
+        len2 += u2[i] * u2[i];
+    }
+    len1 = sqrtf(len1);
+    len2 = sqrtf(len2);
+    if (len2 < 1e-6f) {
+        return true;  // Zero-length move. Nothing to blend.
+    }
+    if (len1 > 1e-6f) {
+        for (size_t i = 0; i < n_axis; i++) {
+            u1[i] /= len1;
+            u2[i] /= len2;
+            cos_theta += u1[i] * u2[i];
+        }
+    }
+
+    // Straight continuations need no curve and reversals cannot be blended.
+    if (len1 <= 1e-6f || cos_theta > 0.9999f || cos_theta < -0.99f) {
+        mc_flush_blend();
+        blend_hold(target, pl_data, position);
+        return true;
+    }
+
+    float sin_half = sqrtf(0.5f * (1.0f - cos_theta));  // sin(theta/2)
+    float L        = 0.5f * std::min(len1, len2);
+    if (tolerance > 0.0f) {
+        L = std::min(L, 2.0f * tolerance / sin_half);
+    }
+
+    float corner[MAX_N_AXIS];
+    float entry[MAX_N_AXIS];
+    float leave[MAX_N_AXIS];
+    for (size_t i = 0; i < n_axis; i++) {
+        corner[i] = blend.target[i];
+        entry[i]  = corner[i] - L * u1[i];
+        leave[i]  = corner[i] + L * u2[i];
+    }
+
+    // Straight part of the held segment, up to where the curve starts.
+    blend.pending = false;
+    mc_linear_no_check(entry, &blend.pl_data, blend.start);
+    if (sys.abort) {
+        return false;
+    }
+
+    // The curve's second derivative has magnitude 4*L*sin(theta/2), so a chord spanning dt of the
+    // parameter deviates by at most L*sin(theta/2)*dt^2/2.
+    uint32_t segments = uint32_t(ceilf(sqrtf(L * sin_half / (2.0f * config->_arcTolerance))));
+    segments          = std::max(segments, uint32_t(1));
+
+    float previous[MAX_N_AXIS];
+    float point[MAX_N_AXIS];
+    float feed_rate = pl_data->feed_rate;
+    copyAxes(previous, entry);
+    for (uint32_t n = 1; n <= segments; n++) {
+        float t = float(n) / segments;
+        float a = (1.0f - t) * (1.0f - t);
+        float b = 2.0f * t * (1.0f - t);
+        float c = t * t;
+        for (size_t i = 0; i < n_axis; i++) {
+            point[i] = a * entry[i] + b * corner[i] + c * leave[i];
+        }
+        pl_data->feed_rate = feed_rate;  // Kinematics may alter the feed rate
+        mc_linear_no_check(point, pl_data, previous);
+        if (sys.abort) {
+            return false;
+        }
+        copyAxes(previous, point);
+    }
+    pl_data->feed_rate = feed_rate;
+
+    blend_hold(target, pl_data, leave);
+    return true;
+}
+
 // Execute an arc in offset mode format. position == current xyz, target == target xyz,
 // offset == offset from current xyz, axis_X defines circle plane in tool space, axis_linear is
 // the direction of helical travel, radius == circle radius, isclockwise boolean. Used
@@ -310,6 +548,7 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, bool away,
     }
     // Setup and queue probing motion. Auto cycle-start should not start the cycle.
     mc_linear(target, pl_data, gc_state.position);
+    mc_flush_blend();
     // Activate the probing state monitor in the stepper module.
     probing = true;
     // Perform probing cycle. Wait here until probe is triggered or motion completes.
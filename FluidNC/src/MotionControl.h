@@ -19,9 +19,25 @@ extern bool probe_succeeded;  // Tracks if last probing cycle was successful.
 // System motion commands must have a line number of zero.
 const int PARKING_MOTION_LINE_NUMBER = 0;
 
-// Execute a linear motion in cartesian space.
+// Execute a linear motion in cartesian space.  Feed motions may be held back to be merged with
+// their successors when segment_merge_tolerance_mm is set.
 bool mc_linear(float* target, plan_line_data_t* pl_data, float* position);
 
+// Execute a linear feed motion in G64 mode, blending the corner with the previous one within
+// tolerance mm.  The parser rejects a negative G64 P, and zero limits the curve only by the
+// segment lengths.  The end of the motion is held back until the next one arrives.
+bool mc_linear_blended(float* target, plan_line_data_t* pl_data, float* position, float tolerance);
+
+// Submit the motion held back by mc_linear() or mc_linear_blended(), if any.
+void mc_flush_blend();
+
+// Release a held motion when the input stream pauses and the planner is about to run dry.
+void mc_blend_idle();
+
+// Submit the held motion, if any, and start the cycle, so that commands which require Idle see
+// the motion as queued instead of running ahead of it.
+void mc_start_held_motion();
+
 // Execute a linear motion in motor space.
 bool mc_move_motors(float* target, plan_line_data_t* pl_data);  // returns true if line was submitted to planner
 
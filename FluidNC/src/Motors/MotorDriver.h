@@ -78,6 +78,22 @@ namespace MotorDrivers {
         // states of the step pins are unknown.
         virtual void unstep();
 
+        // direct_step_pin() reports the native GPIO of the step pin and
+        // its polarity, if step() and unstep() do nothing else than set
+        // it, so that the step ISR may write it together with the step
+        // pins of other motors instead.
+        virtual bool direct_step_pin(pinnum_t& gpio, bool& active_low) { return false; }
+
+        // step_burst() starts count steps on hardware that can time a
+        // train of pulses by itself.  Step i begins times[i] step timer
+        // ticks from now, in increasing order.  step_burst_max() is the
+        // most steps it can take at once, or 0 if the driver cannot do it.
+        // stop_burst() ends a train that is still running; it must be
+        // safe to call from an ISR.
+        virtual uint32_t step_burst_max() { return 0; }
+        virtual void     step_burst(const uint32_t* times, uint32_t count) {}
+        virtual void     stop_burst() {}
+
         // this is used to configure and test motors. This would be used for Trinamic
         virtual void config_motor() {}
 
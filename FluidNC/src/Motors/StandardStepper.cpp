@@ -12,13 +12,19 @@
 #include "../Stepping.h"  // config->_stepping->_engine
 
 #include <esp32-hal-gpio.h>  // gpio
+#include <algorithm>         // std::max
 #include <sdkconfig.h>       // CONFIG_IDF_TARGET_*
+#include <soc/soc.h>         // APB_CLK_FREQ
 
 using namespace Machine;
 
 namespace MotorDrivers {
 
-    static void init_rmt_channel(rmt_channel_t& rmt_chan_num, Pin& step_pin, bool invert_step, uint32_t dir_delay_ms, uint32_t pulse_us) {
+    // RMT ticks are 20 APB clocks, 1/4 us; step timer ticks are shorter by this factor
+    static const uint32_t stepTicksPerRmtTick = Stepping::fStepperTimer / (APB_CLK_FREQ / 20);
+
+    static void init_rmt_channel(
+        rmt_channel_t& rmt_chan_num, rmt_item32_t& step_item, Pin& step_pin, bool invert_step, uint32_t dir_delay_ms, uint32_t pulse_us) {
         static rmt_channel_t next_RMT_chan_num = RMT_CHANNEL_0;
         if (rmt_chan_num == RMT_CHANNEL_MAX) {
             if (next_RMT_chan_num == RMT_CHANNEL_MAX) {
@@ -60,6 +66,7 @@ namespace MotorDrivers {
         rmtItem[0].level1 = !rmtConfig.tx_config.idle_level;
         rmt_config(&rmtConfig);
         rmt_fill_tx_items(rmtConfig.channel, &rmtItem[0], rmtConfig.mem_block_num, 0);
+        step_item = rmtItem[0];
     }
 
     void StandardStepper::init() {
@@ -79,7 +86,7 @@ namespace MotorDrivers {
 
         auto stepping = config->_stepping;
         if (stepping->_engine == Stepping::RMT) {
-            init_rmt_channel(_rmt_chan_num, _step_pin, _invert_step, stepping->_directionDelayUsecs, stepping->_pulseUsecs);
+            init_rmt_channel(_rmt_chan_num, _rmt_step_item, _step_pin, _invert_step, stepping->_directionDelayUsecs, stepping->_pulseUsecs);
         } else {
             _step_pin.setAttr(Pin::Attr::Output);
         }
@@ -95,6 +102,11 @@ namespace MotorDrivers {
 
     void IRAM_ATTR StandardStepper::step() {
         if (config->_stepping->_engine == Stepping::RMT && _rmt_chan_num != RMT_CHANNEL_MAX) {
+            if (_rmt_burst_loaded) {
+                _rmt_burst_loaded                         = false;
+                RMTMEM.chan[_rmt_chan_num].data32[0].val = _rmt_step_item.val;
+                RMTMEM.chan[_rmt_chan_num].data32[1].val = 0;
+            }
 #ifdef CONFIG_IDF_TARGET_ESP32
             RMT.conf_ch[_rmt_chan_num].conf1.mem_rd_rst = 1;
             RMT.conf_ch[_rmt_chan_num].conf1.mem_rd_rst = 0;
@@ -116,6 +128,74 @@ namespace MotorDrivers {
         }
     }
 
+    // Bursts fill one RMT memory block, less the end marker, so that they cannot run into the
+    // memory of the next channel.
+    uint32_t StandardStepper::step_burst_max() {
+        auto stepping = config->_stepping;
+        if (stepping->_engine != Stepping::RMT || !stepping->_rmtBurst || _rmt_chan_num == RMT_CHANNEL_MAX) {
+            return 0;
+        }
+        return SOC_RMT_MEM_WORDS_PER_CHANNEL - 1;
+    }
+
+    // Each item is the gap before a pulse and the pulse.  The gaps place the pulses at their
+    // times, rounded to RMT ticks, but the first is no shorter than the direction delay, as in
+    // _rmt_step_item, and a pulse that cannot start on time starts right after the previous one.
+    void IRAM_ATTR StandardStepper::step_burst(const uint32_t* times, uint32_t count) {
+        volatile rmt_item32_t* mem   = RMTMEM.chan[_rmt_chan_num].data32;
+        rmt_item32_t           item  = _rmt_step_item;
+        uint32_t               lead  = item.duration0;
+        uint32_t               pulse = item.duration1;
+        uint32_t               end   = 0;  // End of the previous pulse, in RMT ticks
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t start = times[i] / stepTicksPerRmtTick;
+            uint32_t gap   = start > end ? start - end : 0;
+            item.duration0 = std::max(gap, i ? uint32_t(1) : lead);
+            mem[i].val     = item.val;
+            end += item.duration0 + pulse;
+        }
+        mem[count].val    = 0;
+        _rmt_burst_loaded = true;
+#ifdef CONFIG_IDF_TARGET_ESP32
+        RMT.conf_ch[_rmt_chan_num].conf1.mem_rd_rst = 1;
+        RMT.conf_ch[_rmt_chan_num].conf1.mem_rd_rst = 0;
+        RMT.conf_ch[_rmt_chan_num].conf1.tx_start   = 1;
+#endif
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+        RMT.chnconf0[_rmt_chan_num].mem_rd_rst_n = 1;
+        RMT.chnconf0[_rmt_chan_num].mem_rd_rst_n = 0;
+        RMT.chnconf0[_rmt_chan_num].tx_start_n   = 1;
+#endif
+    }
+
+    // As rmt_tx_stop() does: on the ESP32, point the channel back at an end marker in the first
+    // item, on the S3, stop it outright.  step() puts the step item back before the next pulse.
+    void IRAM_ATTR StandardStepper::stop_burst() {
+        if (!_rmt_burst_loaded) {
+            return;
+        }
+#ifdef CONFIG_IDF_TARGET_ESP32
+        RMTMEM.chan[_rmt_chan_num].data32[0].val    = 0;
+        RMT.conf_ch[_rmt_chan_num].conf1.tx_start   = 0;
+        RMT.conf_ch[_rmt_chan_num].conf1.mem_rd_rst = 1;
+        RMT.conf_ch[_rmt_chan_num].conf1.mem_rd_rst = 0;
+#endif
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+        RMT.chnconf0[_rmt_chan_num].tx_stop_n     = 1;
+        RMT.chnconf0[_rmt_chan_num].conf_update_n = 1;
+#endif
+    }
+
+    // RMT and I2S pulses are made by peripherals, so only timed GPIO steps can be direct.
+    bool StandardStepper::direct_step_pin(pinnum_t& gpio, bool& active_low) {
+        if (config->_stepping->_engine != Stepping::TIMED || !_step_pin.capabilities().has(Pin::Capabilities::Native)) {
+            return false;
+        }
+        gpio       = _step_pin.getNative(Pin::Capabilities::Native);
+        active_low = _step_pin.getAttr().has(Pin::Attr::ActiveLow);
+        return true;
+    }
+
     void IRAM_ATTR StandardStepper::set_direction(bool dir) { _dir_pin.write(dir); }
 
     void IRAM_ATTR StandardStepper::set_disable(bool disable) { _disable_pin.synchronousWrite(disable); }
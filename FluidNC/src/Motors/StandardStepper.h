@@ -20,6 +20,10 @@ namespace MotorDrivers {
         void set_direction(bool) override;
         void step() override;
         void unstep() override;
+        bool     direct_step_pin(pinnum_t& gpio, bool& active_low) override;
+        uint32_t step_burst_max() override;
+        void     step_burst(const uint32_t* times, uint32_t count) override;
+        void     stop_burst() override;
         void read_settings() override;
 
         void init_step_dir_pins();
@@ -49,5 +53,7 @@ namespace MotorDrivers {
         bool _invert_disable;
 
         rmt_channel_t _rmt_chan_num = RMT_CHANNEL_MAX;
+        rmt_item32_t  _rmt_step_item;              // The single step that step() sends
+        bool          _rmt_burst_loaded = false;  // RMT memory holds a burst instead of _rmt_step_item
     };
 }
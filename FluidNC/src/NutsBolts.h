@@ -7,6 +7,7 @@
 // #define true 1
 
 #include <cstdint>
+#include <cmath>
 #include <string_view>
 #include "Logging.h"
 #include "Driver/delay_usecs.h"
@@ -26,6 +27,13 @@ static inline int toMotor2(int axis) {
 const float MM_PER_INCH = (25.40f);
 const float INCH_PER_MM = (0.0393701f);
 
+// M_PI is not defined in standard C/C++ but some compilers
+// support it anyway.  The following suppresses Intellisense
+// problem reports.
+#ifndef M_PI
+#    define M_PI 3.14159265358979323846
+#endif
+
 // Useful macros
 #define clear_vector(a) memset(a, 0, sizeof(a))
 #ifndef MAX
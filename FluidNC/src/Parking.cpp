@@ -14,10 +14,13 @@ void Parking::moveto(float* target) {
         return;  // Block during abort.
     }
     if (plan_buffer_line(target, &plan_data)) {
-        sys.step_control.executeSysMotion = true;
-        sys.step_control.endMotion        = false;  // Allow parking motion to execute, if feed hold is active.
-        Stepper::parking_setup_buffer();            // Setup step segment buffer for special parking motion case
-        Stepper::prep_buffer();
+        {
+            Stepper::PrepLock lock;
+            sys.step_control.executeSysMotion = true;
+            sys.step_control.endMotion        = false;  // Allow parking motion to execute, if feed hold is active.
+            Stepper::parking_setup_buffer();            // Setup step segment buffer for special parking motion case
+            Stepper::prep_buffer();
+        }
         Stepper::wake_up();
         do {
             protocol_exec_rt_system();
@@ -27,6 +30,7 @@ void Parking::moveto(float* target) {
         } while (sys.step_control.executeSysMotion);
         Stepper::parking_restore_buffer();  // Restore step segment buffer to normal run state.
     } else {
+        Stepper::PrepLock lock;
         sys.step_control.executeSysMotion = false;
         protocol_exec_rt_system();
     }
@@ -77,10 +77,12 @@ const char* Pin::parse(std::string_view pin_str, Pins::PinDetail*& pinImplementa
         pinImplementation = new Pins::GPIOPinDetail(static_cast<pinnum_t>(pin_number), parser);
         return nullptr;
     }
+#ifdef ESP32
     if (string_util::equal_ignore_case(prefix, "i2so")) {
         pinImplementation = new Pins::I2SOPinDetail(static_cast<pinnum_t>(pin_number), parser);
         return nullptr;
     }
+#endif
 
     if (string_util::starts_with_ignore_case(prefix, "uart_channel")) {
         auto num_str     = prefix.substr(strlen("uart_channel"));
@@ -9,24 +9,80 @@
 */
 
 #include "Planner.h"
+#include "PlannerRecalculate.h"
 #include "Machine/MachineConfig.h"
+#include "Driver/psram.h"  // psram_calloc
+#include "InputShaper.h"   // ShapedRamp
 
 #include <cstdlib>  // PSoc Required for labs
 #include <cmath>
-
-static plan_block_t* block_buffer = nullptr;  // A ring buffer for motion instructions
-static uint8_t       block_buffer_tail;       // Index of the block to process now
-static uint8_t       block_buffer_head;       // Index of the next block to be pushed
-static uint8_t       next_buffer_head;        // Index of the next buffer head
-static uint8_t       block_buffer_planned;    // Index of the optimally planned block
+#include <cstddef>  // offsetof
+#include <algorithm>
+
+static uint8_t*      block_buffer = nullptr;  // A ring buffer for motion instructions
+static size_t        block_size;              // Bytes per block, with steps[] cut to the configured axes
+static uint16_t      block_buffer_tail;       // Index of the block to process now
+static uint16_t      block_buffer_head;       // Index of the next block to be pushed
+static uint16_t      next_buffer_head;        // Index of the next buffer head
+static uint16_t      block_buffer_planned;    // Index of the optimally planned block
+
+// When block_buffer is in PSRAM, the hot_blocks blocks starting at the tail are kept in internal
+// RAM instead, in hot_buffer[index % hot_blocks].  The stepper only ever works on the tail block,
+// so it never waits on external memory.  A block moves in when the tail comes within hot_blocks
+// of it, which is the only time its PSRAM copy is read.
+static const uint16_t psram_hot_blocks = 8;
+static uint8_t*       hot_buffer       = nullptr;
+static uint16_t       hot_blocks       = 0;
 
 void plan_init() {
     if (block_buffer) {
-        delete[] block_buffer;
+        if (hot_blocks) {
+            psram_free(block_buffer);
+        } else {
+            delete[] block_buffer;
+        }
+        block_buffer = nullptr;
+    }
+    if (hot_buffer) {
+        delete[] hot_buffer;
+        hot_buffer = nullptr;
+    }
+    hot_blocks = 0;
+    block_size = offsetof(plan_block_t, steps) + config->_axes->_numberAxis * sizeof(uint32_t);
+
+    if (config->_plannerPsram) {
+        // The hot window maps ring indices to slots modulo its size, so the ring must be a multiple of it.
+        config->_planner_blocks = (config->_planner_blocks + psram_hot_blocks - 1) / psram_hot_blocks * psram_hot_blocks;
+        block_buffer            = static_cast<uint8_t*>(psram_calloc(config->_planner_blocks, block_size));
+        if (block_buffer) {
+            hot_blocks = psram_hot_blocks;
+            hot_buffer = new uint8_t[hot_blocks * block_size];
+            log_info("Planner: " << config->_planner_blocks << " blocks in PSRAM");
+        } else {
+            log_warn("Planner: no PSRAM available, using internal RAM");
+        }
+    }
+    if (!block_buffer) {
+        block_buffer = new uint8_t[config->_planner_blocks * block_size];
+    }
+}
+
+// Returns the storage for a ring index.
+static plan_block_t* plan_block(uint16_t index) {
+    if (hot_blocks) {
+        uint16_t offset = index >= block_buffer_tail ? index - block_buffer_tail : index + config->_planner_blocks - block_buffer_tail;
+        if (offset < hot_blocks) {
+            return reinterpret_cast<plan_block_t*>(hot_buffer + (index % hot_blocks) * block_size);
+        }
     }
-    block_buffer = new plan_block_t[config->_planner_blocks];
+    return reinterpret_cast<plan_block_t*>(block_buffer + index * block_size);
 }
 
+// Gives the look-ahead passes indexed access to the blocks wherever they are stored.
+struct PlanRing {
+    plan_block_t& operator[](uint16_t index) { return *plan_block(index); }
+};
+
 // Define planner variables
 typedef struct {
     int32_t position[MAX_N_AXIS];  // The planner position of the tool in absolute steps. Kept separate
@@ -38,7 +94,7 @@ typedef struct {
 static planner_t pl;
 
 // Returns the index of the next block in the ring buffer. Also called by stepper segment buffer.
-static uint8_t plan_next_block_index(uint8_t block_index) {
+static uint16_t plan_next_block_index(uint16_t block_index) {
     block_index++;
     if (block_index == config->_planner_blocks) {
         block_index = 0;
@@ -46,15 +102,6 @@ static uint8_t plan_next_block_index(uint8_t block_index) {
     return block_index;
 }
 
-// Returns the index of the previous block in the ring buffer
-static uint8_t plan_prev_block_index(uint8_t block_index) {
-    if (block_index == 0) {
-        block_index = config->_planner_blocks;
-    }
-    block_index--;
-    return block_index;
-}
-
 /*                            PLANNER SPEED DEFINITION
                                      +--------+   <- current->nominal_speed
                                     /          \
@@ -82,7 +129,7 @@ static uint8_t plan_prev_block_index(uint8_t block_index) {
   are possible. If a new block is added to the buffer, the plan is recomputed according to the said
   guidelines for a new optimal plan.
 
-  To increase computational efficiency of these guidelines, a set of planner block pointers have been
+  To increase computational efficiency of these guidelines, a set of planner block pointers and flags have been
   created to indicate stop-compute points for when the planner guidelines cannot logically make any further
   changes or improvements to the plan when in normal operation and new blocks are streamed and added to the
   planner buffer. For example, if a subset of sequential blocks in the planner have been planned and are
@@ -107,6 +154,10 @@ static uint8_t plan_prev_block_index(uint8_t block_index) {
       this block can never be less than block_buffer_tail and will always be pushed forward and maintain
       this requirement when encountered by the plan_discard_current_block() routine during a cycle.
 
+  Beyond the planned pointer, only the suffix of the buffer whose entry speeds actually change with a new
+  block is recomputed, and blocks flagged nominalLength never depend on the blocks after them. So appending
+  a block costs the length of the final deceleration ramp, however large the buffer. See PlannerRecalculate.h.
+
   NOTE: Since the planner only computes on what's in the planner buffer, some motions with lots of short
   line segments, like G2/3 arcs or complex curves, may seem to move slow. This is because there simply isn't
   enough combined distance traveled in the entire buffer to accelerate up to the nominal speed and then
@@ -120,81 +171,19 @@ static uint8_t plan_prev_block_index(uint8_t block_index) {
   ARM versions should have enough memory and speed for look-ahead blocks numbering up to a hundred or more.
 
 */
-static void planner_recalculate() {
-    if (block_buffer_head == block_buffer_tail) {
-        // Nothing to do; planner buffer is empty.
-        return;
-    }
-    // Initialize block index to the last block in the planner buffer.
-    uint8_t block_index = plan_prev_block_index(block_buffer_head);
-    // Bail. Can't do anything with one only one plan-able block.
-    if (block_index == block_buffer_planned) {
-        return;
-    }
-    // Reverse Pass: Coarsely maximize all possible deceleration curves back-planning from the last
-    // block in buffer. Cease planning when the last optimal planned or tail pointer is reached.
-    // NOTE: Forward pass will later refine and correct the reverse pass to create an optimal plan.
-    float         entry_speed_sqr;
-    plan_block_t* next;
-    plan_block_t* current = &block_buffer[block_index];
-    // Calculate maximum entry speed for last block in buffer, where the exit speed is always zero.
-    current->entry_speed_sqr = MIN(current->max_entry_speed_sqr, 2 * current->acceleration * current->millimeters);
-    block_index              = plan_prev_block_index(block_index);
-    if (block_index == block_buffer_planned) {  // Only two plannable blocks in buffer. Reverse pass complete.
-        // Check if the first block is the tail. If so, notify stepper to update its current parameters.
-        if (block_index == block_buffer_tail) {
-            Stepper::update_plan_block_parameters();
-        }
-    } else {  // Three or more plan-able blocks
-        while (block_index != block_buffer_planned) {
-            next        = current;
-            current     = &block_buffer[block_index];
-            block_index = plan_prev_block_index(block_index);
-            // Check if next block is the tail block(=planned block). If so, update current stepper parameters.
-            if (block_index == block_buffer_tail) {
-                Stepper::update_plan_block_parameters();
-            }
-            // Compute maximum entry speed decelerating over the current block from its exit speed.
-            if (current->entry_speed_sqr != current->max_entry_speed_sqr) {
-                entry_speed_sqr = next->entry_speed_sqr + 2 * current->acceleration * current->millimeters;
-                if (entry_speed_sqr < current->max_entry_speed_sqr) {
-                    current->entry_speed_sqr = entry_speed_sqr;
-                } else {
-                    current->entry_speed_sqr = current->max_entry_speed_sqr;
-                }
-            }
-        }
-    }
-    // Forward Pass: Forward plan the acceleration curve from the planned pointer onward.
-    // Also scans for optimal plan breakpoints and appropriately updates the planned pointer.
-    next        = &block_buffer[block_buffer_planned];  // Begin at buffer planned pointer
-    block_index = plan_next_block_index(block_buffer_planned);
-    while (block_index != block_buffer_head) {
-        current = next;
-        next    = &block_buffer[block_index];
-        // Any acceleration detected in the forward pass automatically moves the optimal planned
-        // pointer forward, since everything before this is all optimal. In other words, nothing
-        // can improve the plan from the buffer tail to the planned pointer by logic.
-        if (current->entry_speed_sqr < next->entry_speed_sqr) {
-            entry_speed_sqr = current->entry_speed_sqr + 2 * current->acceleration * current->millimeters;
-            // If true, current block is full-acceleration and we can move the planned pointer forward.
-            if (entry_speed_sqr < next->entry_speed_sqr) {
-                next->entry_speed_sqr = entry_speed_sqr;  // Always <= max_entry_speed_sqr. Backward pass sets this.
-                block_buffer_planned  = block_index;      // Set optimal plan pointer.
-            }
-        }
-        // Any block set at its maximum entry speed also creates an optimal plan up to this
-        // point in the buffer. When the plan is bracketed by either the beginning of the
-        // buffer and a maximum entry speed or two maximum entry speeds, every block in between
-        // cannot logically be further improved. Hence, we don't have to recompute them anymore.
-        if (next->entry_speed_sqr == next->max_entry_speed_sqr) {
-            block_buffer_planned = block_index;
-        }
-        block_index = plan_next_block_index(block_index);
-    }
+static void planner_recalculate(bool full = false) {
+    PlanRing ring;
+    plan_recalculate_ring(ring,
+                          uint16_t(config->_planner_blocks),
+                          block_buffer_tail,
+                          block_buffer_head,
+                          block_buffer_planned,
+                          full,
+                          Stepper::update_plan_block_parameters);
 }
 
 void plan_reset() {
+    Stepper::PrepLock lock;
     memset(&pl, 0, sizeof(planner_t));  // Clear planner struct
     plan_reset_buffer();
 }
@@ -209,18 +198,26 @@ void plan_reset_buffer() {
 // Called from stepper pulse function when the block is complete
 void plan_discard_current_block() {
     if (block_buffer_head != block_buffer_tail) {  // Discard non-empty buffer.
-        uint8_t block_index = plan_next_block_index(block_buffer_tail);
+        uint16_t block_index = plan_next_block_index(block_buffer_tail);
         // Push block_buffer_planned pointer, if encountered.
         if (block_buffer_tail == block_buffer_planned) {
             block_buffer_planned = block_index;
         }
         block_buffer_tail = block_index;
+        // Move the block that just came within the hot window out of PSRAM.
+        if (hot_blocks) {
+            uint16_t entering = (block_buffer_tail + hot_blocks - 1) % config->_planner_blocks;
+            uint16_t queued   = (block_buffer_head + config->_planner_blocks - block_buffer_tail) % config->_planner_blocks;
+            if (hot_blocks - 1 < queued) {
+                memcpy(hot_buffer + (entering % hot_blocks) * block_size, block_buffer + entering * block_size, block_size);
+            }
+        }
     }
 }
 
 // Returns address of planner buffer block used by system motions. Called by segment generator.
 plan_block_t* plan_get_system_motion_block() {
-    return &block_buffer[block_buffer_head];
+    return plan_block(block_buffer_head);
 }
 
 // Returns address of first planner block, if available. Called by various main program functions.
@@ -228,15 +225,15 @@ plan_block_t* plan_get_current_block() {
     if (block_buffer_head == block_buffer_tail) {
         return NULL;  // Buffer empty
     }
-    return &block_buffer[block_buffer_tail];
+    return plan_block(block_buffer_tail);
 }
 
 float plan_get_exec_block_exit_speed_sqr() {
-    uint8_t block_index = plan_next_block_index(block_buffer_tail);
+    uint16_t block_index = plan_next_block_index(block_buffer_tail);
     if (block_index == block_buffer_head) {
         return 0.0f;
     }
-    return block_buffer[block_index].entry_speed_sqr;
+    return plan_block(block_index)->entry_speed_sqr;
 }
 
 // Returns the availability status of the block ring buffer. True, if full.
@@ -258,6 +255,9 @@ float plan_compute_profile_nominal_speed(plan_block_t* block) {
             nominal_speed = block->rapid_rate;
         }
     }
+    if (!(block->motion.systemMotion)) {
+        nominal_speed *= (0.01f * sys.underrun_scale);
+    }
     if (nominal_speed > MINIMUM_FEED_RATE) {
         return nominal_speed;
     }
@@ -277,16 +277,20 @@ static void plan_compute_profile_parameters(plan_block_t* block, float nominal_s
     if (block->max_entry_speed_sqr > block->max_junction_speed_sqr) {
         block->max_entry_speed_sqr = block->max_junction_speed_sqr;
     }
+
+    // A block long enough to stop from its nominal speed never needs to look past itself.
+    block->flags.nominalLength = nominal_speed * nominal_speed <= 2 * block->acceleration * block->millimeters;
 }
 
 // Re-calculates buffered motions profile parameters upon a motion-based override change.
 void plan_update_velocity_profile_parameters() {
-    uint8_t       block_index = block_buffer_tail;
+    Stepper::PrepLock lock;
+    uint16_t      block_index = block_buffer_tail;
     plan_block_t* block;
     float         nominal_speed;
     float         prev_nominal_speed = SOME_LARGE_VALUE;  // Set high for first block nominal speed calculation.
     while (block_index != block_buffer_head) {
-        block         = &block_buffer[block_index];
+        block         = plan_block(block_index);
         nominal_speed = plan_compute_profile_nominal_speed(block);
         plan_compute_profile_parameters(block, nominal_speed, prev_nominal_speed);
         prev_nominal_speed = nominal_speed;
@@ -299,9 +303,10 @@ void plan_update_velocity_profile_parameters() {
 }
 
 bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
+    Stepper::PrepLock lock;
     // Prepare and initialize new block. Copy relevant pl_data for block execution.
-    plan_block_t* block = &block_buffer[block_buffer_head];
-    memset(block, 0, sizeof(plan_block_t));  // Zero all block values.
+    plan_block_t* block = plan_block(block_buffer_head);
+    memset(block, 0, block_size);  // Zero all block values.
     block->motion        = pl_data->motion;
     block->coolant       = pl_data->coolant;
     block->spindle       = pl_data->spindle;
@@ -312,6 +317,10 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
     // Compute and store initial move distance data.
     int32_t target_steps[MAX_N_AXIS], position_steps[MAX_N_AXIS];
     float   unit_vec[MAX_N_AXIS], delta_mm;
+    float   tool_path_sqr = 0.0f;  // Squared distance travelled by the tool tip
+    bool    has_rotary    = false;
+    float   dominant_mm   = 0.0f;  // Travel of the axis whose shaper the stepper applies
+    bool    shaped        = false;
     // Copy position data based on type of motion being planned.
     if (block->motion.systemMotion) {
         get_motor_steps(position_steps);
@@ -333,6 +342,17 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
         block->step_event_count = MAX(block->step_event_count, block->steps[idx]);
         delta_mm                = steps_to_mpos((target_steps[idx] - position_steps[idx]), idx);
         unit_vec[idx]           = delta_mm;  // Store unit vector numerator
+        if (fabsf(delta_mm) > dominant_mm) {
+            dominant_mm = fabsf(delta_mm);
+            shaped      = config->_axes->_axis[idx]->_shaper.n_impulses != 0;
+        }
+        // A rotary axis moves the tool tip by its arc length at the configured radius.
+        float radius = config->_axes->_axis[idx]->_rotaryRadius;
+        if (radius > 0.0f) {
+            delta_mm *= radius * float(M_PI / 180.0);
+            has_rotary = true;
+        }
+        tool_path_sqr += delta_mm * delta_mm;
         // Set direction bits. Bit enabled always means direction is negative.
         if (delta_mm < 0.0) {
             block->direction_bits |= bitnum_to_mask(idx);
@@ -349,7 +369,12 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
     // if they are also orthogonal/independent. Operates on the absolute value of the unit vector.
     block->millimeters  = convert_delta_vector_to_unit_vector(unit_vec);
     block->acceleration = limit_acceleration_by_axis_maximum(unit_vec);
-    block->rapid_rate   = limit_rate_by_axis_maximum(unit_vec);
+    float peak_ratio    = config->_smoothRamps ? sCurvePeakRatio : 1.0f;
+    if (shaped) {
+        peak_ratio = std::max(peak_ratio, ShapedRamp::peak_ratio);
+    }
+    block->acceleration /= peak_ratio;
+    block->rapid_rate = limit_rate_by_axis_maximum(unit_vec);
     // Store programmed rate.
     if (block->motion.rapidMotion) {
         block->programmed_rate = block->rapid_rate;
@@ -357,6 +382,13 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
         block->programmed_rate = pl_data->feed_rate;
         if (block->motion.inverseTime) {
             block->programmed_rate *= block->millimeters;
+        } else if (has_rotary && !block->motion.systemMotion && !block->is_jog) {
+            // The feed rate is the tool tip speed, but the planner works in axis units, where a rotary
+            // axis counts degrees.  Scale the rate so the move takes as long as the tool path needs.
+            float tool_path = sqrtf(tool_path_sqr);
+            if (tool_path > 0.0f) {
+                block->programmed_rate *= block->millimeters / tool_path;
+            }
         }
     }
     // TODO: Need to check this method handling zero junction speeds when starting from rest.
@@ -410,6 +442,20 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
                         (junction_acceleration * config->_junctionDeviation * sin_theta_d2) / (1.0f - sin_theta_d2));
             }
         }
+        // Per-axis jerk: at junction speed v, axis i changes speed abruptly by v * |delta unit_vec[i]|,
+        // which must stay within that axis's limit.
+        float max_jerk_speed = SOME_LARGE_VALUE;
+        for (size_t idx = 0; idx < n_axis; idx++) {
+            float jerk = config->_axes->_axis[idx]->_junctionJerk;
+            float dv   = fabsf(unit_vec[idx] - pl.previous_unit_vec[idx]);
+            if (jerk > 0.0f && dv * max_jerk_speed > jerk) {
+                max_jerk_speed = jerk / dv;
+            }
+        }
+        if (max_jerk_speed < SOME_LARGE_VALUE) {
+            block->max_junction_speed_sqr =
+                MAX(MINIMUM_JUNCTION_SPEED * MINIMUM_JUNCTION_SPEED, MIN(block->max_junction_speed_sqr, max_jerk_speed * max_jerk_speed));
+        }
     }
     // Block system motion from updating this data to ensure next g-code motion is computed correctly.
     if (!(block->motion.systemMotion)) {
@@ -439,7 +485,7 @@ void plan_sync_position() {
 
 // Returns the number of available blocks are in the planner buffer.
 // Called from report_realtime_status
-uint8_t plan_get_block_buffer_available() {
+uint16_t plan_get_block_buffer_available() {
     if (block_buffer_head >= block_buffer_tail) {
         return (config->_planner_blocks - 1) - (block_buffer_head - block_buffer_tail);
     } else {
@@ -450,8 +496,9 @@ uint8_t plan_get_block_buffer_available() {
 // Re-initialize buffer plan with a partially completed block, assumed to exist at the buffer tail.
 // Called after a steppers have come to a complete stop for a feed hold and the cycle is stopped.
 void plan_cycle_reinitialize() {
+    Stepper::PrepLock lock;
     // Re-plan from a complete stop. Reset planner entry speeds and buffer planned pointer.
     Stepper::update_plan_block_parameters();
     block_buffer_planned = block_buffer_tail;
-    planner_recalculate();
+    planner_recalculate(true);
 }
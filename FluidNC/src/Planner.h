@@ -13,6 +13,7 @@
 #include "SpindleDatatypes.h"  // SpindleState
 #include "GCode.h"             // CoolantState
 #include "Types.h"             // AxisMask
+#include "PlannerRecalculate.h"  // PlanFlags
 
 #include <cstdint>
 
@@ -26,40 +27,48 @@ struct PlMotion {
 
 // This struct stores a linear movement of a g-code block motion with its critical "nominal" values
 // are as specified in the source g-code.
+// NOTE: Blocks are allocated with room for the configured number of axes only, so steps[] must stay
+// last, and blocks must not be copied or sized with sizeof().  The fields the stepper segment
+// generator reads for every segment come first, so they share a cache line.
 struct plan_block_t {
     // Fields used by the bresenham algorithm for tracing the line
     // NOTE: Used by stepper algorithm to execute the block correctly. Do not alter these values.
-
-    uint32_t steps[MAX_N_AXIS];  // Step count along each axis
-    uint32_t step_event_count;   // The maximum step axis count and number of steps required to complete this block.
-    uint8_t  direction_bits;     // The direction bit set for this block (refers to *_DIRECTION_BIT in config.h)
+    uint32_t step_event_count;  // The maximum step axis count and number of steps required to complete this block.
+    uint8_t  direction_bits;    // The direction bit set for this block (refers to *_DIRECTION_BIT in config.h)
 
     // Block condition data to ensure correct execution depending on states and overrides.
-    PlMotion     motion;       // Block bitflag motion conditions. Copied from pl_line_data.
-    SpindleState spindle;      // Spindle enable state
-    CoolantState coolant;      // Coolant state
-    int32_t      line_number;  // Block line number for real-time reporting. Copied from pl_line_data.
+    PlMotion     motion;   // Block bitflag motion conditions. Copied from pl_line_data.
+    PlanFlags    flags;    // Planner state of the block
+    SpindleState spindle;  // Spindle enable state
+    CoolantState coolant;  // Coolant state
+    bool         is_jog;
 
     // Fields used by the motion planner to manage acceleration. Some of these values may be updated
     // by the stepper module during execution of special motion cases for replanning purposes.
-    float entry_speed_sqr;      // The current planned entry speed at block junction in (mm/min)^2
-    float max_entry_speed_sqr;  // Maximum allowable entry speed based on the minimum of junction limit and
-    //   neighboring nominal speeds with overrides in (mm/min)^2
-    float acceleration;  // Axis-limit adjusted line acceleration in (mm/min^2). Does not change.
-    float millimeters;   // The remaining distance for this block to be executed in (mm).
+    float entry_speed_sqr;  // The current planned entry speed at block junction in (mm/min)^2
+    float acceleration;     // Axis-limit adjusted line acceleration in (mm/min^2). Does not change.
+    float millimeters;      // The remaining distance for this block to be executed in (mm).
     // NOTE: This value may be altered by stepper algorithm during execution.
-
-    // Stored rate limiting data used by planner when changes occur.
-    float max_junction_speed_sqr;  // Junction entry speed limit based on direction vectors in (mm/min)^2
-    float rapid_rate;              // Axis-limit adjusted maximum rate for this block direction in (mm/min)
-    float programmed_rate;         // Programmed rate of this block (mm/min).
+    float rapid_rate;       // Axis-limit adjusted maximum rate for this block direction in (mm/min)
+    float programmed_rate;  // Programmed rate of this block (mm/min).
 
     // Stored spindle speed data used by spindle overrides and resuming methods.
     SpindleSpeed spindle_speed;  // Block spindle speed. Copied from pl_line_data.
+    int32_t      line_number;    // Block line number for real-time reporting. Copied from pl_line_data.
 
-    bool is_jog;
+    // Stored rate limiting data used only by the planner when changes occur.
+    float max_entry_speed_sqr;  // Maximum allowable entry speed based on the minimum of junction limit and
+    //   neighboring nominal speeds with overrides in (mm/min)^2
+    float max_junction_speed_sqr;  // Junction entry speed limit based on direction vectors in (mm/min)^2
+
+    uint32_t steps[MAX_N_AXIS];  // Step count along each configured axis
 };
 
+// The S-curve ramps of the segment generator reach this multiple of their average acceleration
+// halfway through, so with smooth_ramps the blocks are planned with the axis acceleration
+// limits divided by it.
+const float sCurvePeakRatio = 1.875f;
+
 // Planner data prototype. Must be used when passing new motions to the planner.
 struct plan_line_data_t {
     float        feed_rate;       // Desired feed rate for line motion. Value is ignored, if rapid motion.
@@ -95,7 +104,7 @@ plan_block_t* plan_get_system_motion_block();
 plan_block_t* plan_get_current_block();
 
 // Increment block index with wrap-around
-static uint8_t plan_next_block_index(uint8_t block_index);
+static uint16_t plan_next_block_index(uint16_t block_index);
 
 // Called by step segment buffer when computing executing block velocity profile.
 float plan_get_exec_block_exit_speed_sqr();
@@ -113,7 +122,7 @@ void plan_sync_position();
 void plan_cycle_reinitialize();
 
 // Returns the number of available blocks are in the planner buffer.
-uint8_t plan_get_block_buffer_available();
+uint16_t plan_get_block_buffer_available();
 
 // Returns the status of the block ring buffer. True, if buffer is full.
 uint8_t plan_check_full_buffer();
@@ -0,0 +1,98 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  PlannerRecalculate.h - the look-ahead passes of the planner, kept free of machine state so
+  that they can be exercised and benchmarked on the host.
+*/
+
+#include <algorithm>
+#include <cstdint>
+
+// Per-block planner flags.
+struct PlanFlags {
+    // The block can stop from its nominal speed within its own length, so its entry speed is its
+    // maximum entry speed whatever follows it.  The reverse pass never has to look past it.
+    uint8_t nominalLength : 1;
+};
+
+// Recalculates the entry speeds of the blocks in a planner ring after one was appended at head - 1.
+// Blocks from the tail up to and including planned are optimal and are never revisited.  Beyond
+// that, the reverse pass stops at the first block whose entry speed is unchanged by the new block,
+// since nothing ahead of it can change either, and the forward pass starts just ahead of that point.
+// So the work per append is bounded by the length of the changed suffix, which is the deceleration
+// ramp at the end of the plan, rather than by the size of the ring.
+//
+// full forces both passes to cover everything after planned.  It is needed when the entry speed of
+// the tail or the speed limits of the blocks have changed, as after a feed hold or an override.
+//
+// Ring is anything indexable by Index yielding a block with entry_speed_sqr, max_entry_speed_sqr,
+// acceleration, millimeters and flags.  tail_exit_changed() is called before the reverse pass changes
+// the entry speed of the block after the tail, so the stepper can reload the profile of the executing
+// block before the forward pass starts from it.
+template <typename Ring, typename Index, typename Callback>
+void plan_recalculate_ring(Ring& ring, Index size, Index tail, Index head, Index& planned, bool full, Callback tail_exit_changed) {
+    auto next_index = [size](Index index) { return Index(index + 1 == size ? 0 : index + 1); };
+    auto prev_index = [size](Index index) { return Index(index == 0 ? size - 1 : index - 1); };
+
+    if (head == tail) {
+        return;  // Nothing to do; planner buffer is empty.
+    }
+    Index index = prev_index(head);
+    if (index == planned) {
+        return;  // Can't do anything with only one plan-able block.
+    }
+    const Index after_tail = next_index(tail);
+
+    // Reverse pass: maximize the deceleration curves back-planning from the last block, whose exit
+    // speed is always zero.  The forward pass later corrects anything that cannot be reached.
+    auto  current = &ring[index];
+    float exit    = 0.0f;
+    Index dirty   = index;  // Oldest block whose entry speed changed
+    while (true) {
+        float entry_speed_sqr = current->max_entry_speed_sqr;
+        if (!current->flags.nominalLength) {
+            entry_speed_sqr = std::min(entry_speed_sqr, exit + 2 * current->acceleration * current->millimeters);
+        }
+        if (entry_speed_sqr == current->entry_speed_sqr && !full && index != dirty) {
+            break;  // Unchanged, so nothing before it can change.
+        }
+        if (index == after_tail) {
+            tail_exit_changed();
+        }
+        current->entry_speed_sqr = entry_speed_sqr;
+        dirty                    = index;
+        index                    = prev_index(index);
+        if (index == planned) {
+            break;
+        }
+        exit    = current->entry_speed_sqr;
+        current = &ring[index];
+    }
+
+    // Forward pass: limit each entry speed to what can be reached from the block before it, and
+    // move the planned pointer past every block that can no longer be improved.
+    index     = full ? planned : prev_index(dirty);
+    auto next = &ring[index];
+    index     = next_index(index);
+    while (index != head) {
+        current = next;
+        next    = &ring[index];
+        // Any acceleration detected in the forward pass automatically moves the optimal planned
+        // pointer forward, since everything before this is all optimal.
+        if (current->entry_speed_sqr < next->entry_speed_sqr) {
+            float entry_speed_sqr = current->entry_speed_sqr + 2 * current->acceleration * current->millimeters;
+            // If true, current block is full-acceleration and we can move the planned pointer forward.
+            if (entry_speed_sqr < next->entry_speed_sqr) {
+                next->entry_speed_sqr = entry_speed_sqr;  // Always <= max_entry_speed_sqr. Backward pass sets this.
+                planned               = index;            // Set optimal plan pointer.
+            }
+        }
+        // A block at its maximum entry speed brackets an optimal plan up to this point.
+        if (next->entry_speed_sqr == next->max_entry_speed_sqr) {
+            planned = index;
+        }
+        index = next_index(index);
+    }
+}
@@ -22,6 +22,7 @@
 #include "FileStream.h"           // FileStream()
 #include "xmodem.h"               // xmodemReceive(), xmodemTransmit()
 #include "StartupLog.h"           // startupLog
+#include "Stepper.h"              // Stepper::stats
 #include "Driver/fluidnc_gpio.h"  // gpio_dump()
 
 #include "FluidPath.h"
@@ -256,6 +257,7 @@ static Error toggle_check_mode(const char* value, WebUI::AuthenticationLevel aut
     // Perform reset when toggling off. Check g-code mode should only work when
     // idle and ready, regardless of alarm locks. This is mainly to keep things
     // simple and consistent.
+    mc_start_held_motion();
     if (state_is(State::CheckMode)) {
         report_feedback_message(Message::Disabled);
         sys.abort = true;
@@ -840,6 +842,33 @@ static Error showHeap(const char* value, WebUI::AuthenticationLevel auth_level,
     return Error::Ok;
 }
 
+static Error showStepperStats(const char* value, WebUI::AuthenticationLevel auth_level, Channel& out) {
+    if (value) {
+        if (strcasecmp(value, "reset")) {
+            return Error::InvalidValue;
+        }
+        Stepper::reset_stats();
+        return Error::Ok;
+    }
+    auto stepping = config->_stepping;
+    auto stats    = Stepper::read_stats();
+    if (!stepping->_reportStats) {
+        log_info("Step ISR times need stepping/report_stats");
+    } else if (stats.isr_count) {
+        log_info("Step ISR calls:" << stats.isr_count << " min:" << Stepper::stats_ns(stats.isr_min)
+                                   << "ns avg:" << Stepper::stats_ns(stats.isr_total / stats.isr_count)
+                                   << "ns max:" << Stepper::stats_ns(stats.isr_max) << "ns");
+    } else {
+        log_info("Step ISR calls:0");
+    }
+    log_info("Segments:" << stepping->_segments << " low water:" << (stats.low_water == UINT32_MAX ? 0 : stats.low_water)
+                         << " underruns:" << stats.underruns);
+    uint32_t rate = stats.min_step_period == UINT32_MAX ? 0 : Machine::Stepping::fStepperTimer / stats.min_step_period;
+    log_info("Max step rate:" << rate << "/s engine:" << stepTypes[stepping->_engine].name << " limit:" << stepping->maxPulsesPerSec()
+                              << "/s");
+    return Error::Ok;
+}
+
 // Commands use the same syntax as Settings, but instead of setting or
 // displaying a persistent value, a command causes some action to occur.
 // That action could be anything, from displaying a run-time parameter
@@ -900,6 +929,7 @@ void make_user_commands() {
 
     new UserCommand("SA", "Alarm/Send", sendAlarm, anyState);
     new UserCommand("Heap", "Heap/Show", showHeap, anyState);
+    new UserCommand("STS", "Stepper/Stats", showStepperStats, anyState);
     new UserCommand("SS", "Startup/Show", showStartupLog, anyState);
 
     new UserCommand("RI", "Report/Interval", setReportInterval, anyState);
@@ -949,6 +979,11 @@ Error do_command_or_setting(const char* key, const char* value, WebUI::Authentic
     // $key= with nothing following the = .  It is important to distinguish
     // those cases so that you can say "$N0=" to clear a startup line.
 
+    // A new value must not take effect ahead of motion that is still held back
+    if (value) {
+        mc_start_held_motion();
+    }
+
     // First search the yaml settings by name. If found, set a new
     // value if one is given, otherwise display the current value
     try {
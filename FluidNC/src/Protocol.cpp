@@ -18,6 +18,7 @@
 #include "MotionControl.h"  // PARKING_MOTION_LINE_NUMBER
 #include "Settings.h"       // settings_execute_startup
 #include "Machine/LimitPin.h"
+#include "Driver/StepTimer.h"  // stepTimerPoll
 
 volatile ExecAlarm lastAlarm;  // The most recent alarm code
 
@@ -210,6 +211,9 @@ void     protocol_main_loop() {
             // Tell the input polling task that the line has been processed,
             // so it can give us another one when available
             activeChannel = nullptr;
+        } else {
+            // Let a motion held back for G64 blending go if the stream has paused.
+            mc_blend_idle();
         }
 
         // Auto-cycle start any queued moves.
@@ -260,6 +264,7 @@ void     protocol_main_loop() {
 // Block until all buffered steps are executed or in a cycle state. Works with feed hold
 // during a synchronize call, if it should happen. Also, waits for clean cycle end.
 void protocol_buffer_synchronize() {
+    mc_flush_blend();  // A motion held back for G64 blending has no successor to wait for
     do {
         // Restart motion if there are blocks in the planner queue
         protocol_auto_cycle_start();
@@ -374,7 +379,7 @@ static void protocol_do_start() {
 }
 
 static void protocol_do_alarm(void* alarmVoid) {
-    lastAlarm = (ExecAlarm)((int)alarmVoid);
+    lastAlarm = (ExecAlarm)((intptr_t)alarmVoid);
     if (spindle->_off_on_alarm) {
         spindle->stop();
     }
@@ -394,7 +399,10 @@ static void protocol_do_alarm(void* alarmVoid) {
     set_state(State::Alarm);
 }
 
+// Step control changes are made under the prep lock so that the prep task never
+// sees a half-applied transition.
 static void protocol_start_holding() {
+    Stepper::PrepLock lock;
     if (!(sys.suspend.bit.motionCancel || sys.suspend.bit.jogCancel)) {  // Block, if already holding.
         sys.step_control = {};
         if (!Stepper::update_plan_block_parameters()) {  // Notify stepper module to recompute for hold deceleration.
@@ -405,11 +413,19 @@ static void protocol_start_holding() {
 }
 
 static void protocol_cancel_jogging() {
+    Stepper::PrepLock lock;
     if (!sys.suspend.bit.motionCancel) {
         sys.suspend.bit.jogCancel = true;
     }
 }
 
+// Starts the hold and the jog cancel as one transition.
+static void protocol_hold_jogging() {
+    Stepper::PrepLock lock;
+    protocol_start_holding();
+    protocol_cancel_jogging();
+}
+
 static void protocol_hold_complete() {
     sys.suspend.value            = 0;
     sys.suspend.bit.holdComplete = true;
@@ -438,8 +454,7 @@ void protocol_do_motion_cancel() {
             break;
 
         case State::Jog:
-            protocol_start_holding();
-            protocol_cancel_jogging();
+            protocol_hold_jogging();
             // When jogging, we do not set motionCancel, hence return not break
             return;
 
@@ -484,8 +499,7 @@ static void protocol_do_feedhold() {
             break;
 
         case State::Jog:
-            protocol_start_holding();
-            protocol_cancel_jogging();
+            protocol_hold_jogging();
             return;  // Do not change the state to Hold
     }
     set_state(State::Hold);
@@ -516,6 +530,7 @@ static void protocol_do_safety_door() {
             if (!sys.suspend.bit.jogCancel && sys.suspend.bit.initiateRestore) {  // Actively restoring
                 // Set hold and reset appropriate control flags to restart parking sequence.
                 if (sys.step_control.executeSysMotion) {
+                    Stepper::PrepLock lock;
                     Stepper::update_plan_block_parameters();  // Notify stepper module to recompute for hold deceleration.
                     sys.step_control                  = {};
                     sys.step_control.executeHold      = true;
@@ -536,8 +551,7 @@ static void protocol_do_safety_door() {
             protocol_start_holding();
             break;
         case State::Jog:
-            protocol_start_holding();
-            protocol_cancel_jogging();
+            protocol_hold_jogging();
             break;
     }
     if (!sys.suspend.bit.jogCancel) {
@@ -587,6 +601,7 @@ void protocol_cancel_disable_steppers() {
 static void protocol_do_initiate_cycle() {
     // log_debug("protocol_do_initiate_cycle " << state_name());
     // Start cycle only if queued motions exist in planner buffer and the motion is not canceled.
+    Stepper::PrepLock lock;
     sys.step_control = {};  // Restore step control to normal operation
     plan_block_t* pb;
     if ((pb = plan_get_current_block()) && !sys.suspend.bit.motionCancel) {
@@ -601,6 +616,7 @@ static void protocol_do_initiate_cycle() {
 }
 static void protocol_initiate_homing_cycle() {
     log_debug("protocol_initiate_homing_cycle " << state_name());
+    Stepper::PrepLock lock;
     sys.step_control                  = {};    // Restore step control to normal operation
     sys.suspend.value                 = 0;     // Break suspend state.
     sys.step_control.executeSysMotion = true;  // Set to execute homing motion and clear existing flags.
@@ -694,6 +710,7 @@ void protocol_do_cycle_stop() {
             if (!soft_limit && !sys.suspend.bit.jogCancel) {
                 // Hold complete. Set to indicate ready to resume.  Remain in HOLD or DOOR states until user
                 // has issued a resume command or reset.
+                Stepper::PrepLock lock;
                 plan_cycle_reinitialize();
                 if (sys.step_control.executeHold) {
                     sys.suspend.bit.holdComplete = true;
@@ -713,6 +730,7 @@ void protocol_do_cycle_stop() {
             // Motion complete. Includes CYCLE/JOG/HOMING states and jog cancel/motion cancel/soft limit events.
             // NOTE: Motion and jog cancel both immediately return to idle after the hold completes.
             if (sys.suspend.bit.jogCancel) {  // For jog cancel, flush buffers and sync positions.
+                Stepper::PrepLock lock;
                 sys.step_control = {};
                 plan_reset();
                 Stepper::reset();
@@ -778,7 +796,10 @@ void protocol_exec_rt_system() {
         case State::SafetyDoor:
         case State::Homing:
         case State::Jog:
-            Stepper::prep_buffer();
+            if (!Stepper::prep_in_task) {
+                Stepper::prep_buffer();
+            }
+            stepTimerPoll();
             break;
     }
 }
@@ -900,7 +921,7 @@ static void protocol_exec_rt_suspend() {
 }
 
 static void protocol_do_feed_override(void* incrementvp) {
-    int increment = int(incrementvp);
+    int increment = int(intptr_t(incrementvp));
     int percent;
     if (increment == FeedOverride::Default) {
         percent = FeedOverride::Default;
@@ -918,8 +939,19 @@ static void protocol_do_feed_override(void* incrementvp) {
     }
 }
 
+static void protocol_do_underrun_scale(void* percentvp) {
+    int percent = int(intptr_t(percentvp));
+    if (percent != sys.underrun_scale) {
+        if (percent < sys.underrun_scale) {
+            log_warn("Step segments running low, slowing to " << percent << "%");
+        }
+        sys.underrun_scale = percent;
+        update_velocities();
+    }
+}
+
 static void protocol_do_rapid_override(void* percentvp) {
-    int percent = int(percentvp);
+    int percent = int(intptr_t(percentvp));
     if (percent != sys.r_override) {
         sys.r_override = percent;
         update_velocities();
@@ -928,7 +960,7 @@ static void protocol_do_rapid_override(void* percentvp) {
 
 static void protocol_do_spindle_override(void* incrementvp) {
     int percent;
-    int increment = int(incrementvp);
+    int increment = int(intptr_t(incrementvp));
     if (increment == SpindleSpeedOverride::Default) {
         percent = SpindleSpeedOverride::Default;
     } else {
@@ -954,7 +986,7 @@ static void protocol_do_spindle_override(void* incrementvp) {
 }
 
 static void protocol_do_accessory_override(void* type) {
-    switch (int(type)) {
+    switch (int(intptr_t(type))) {
         case AccessoryOverride::SpindleStopOvr:
             // Spindle stop override allowed only while in HOLD state.
             if (state_is(State::Hold)) {
@@ -1027,6 +1059,7 @@ void protocol_do_rt_reset() {
 
 const ArgEvent feedOverrideEvent { protocol_do_feed_override };
 const ArgEvent rapidOverrideEvent { protocol_do_rapid_override };
+const ArgEvent underrunScaleEvent { protocol_do_underrun_scale };
 const ArgEvent spindleOverrideEvent { protocol_do_spindle_override };
 const ArgEvent accessoryOverrideEvent { protocol_do_accessory_override };
 const ArgEvent limitEvent { protocol_do_limit };
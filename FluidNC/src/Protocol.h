@@ -86,6 +86,7 @@ enum AccessoryOverride {
 
 extern const ArgEvent feedOverrideEvent;
 extern const ArgEvent rapidOverrideEvent;
+extern const ArgEvent underrunScaleEvent;
 extern const ArgEvent spindleOverrideEvent;
 extern const ArgEvent accessoryOverrideEvent;
 extern const ArgEvent limitEvent;
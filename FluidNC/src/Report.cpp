@@ -326,6 +326,10 @@ void report_gcode_modes(Channel& channel) {
             break;
     }
 
+    if (gc_state.modal.control == ControlMode::Continuous) {
+        msg << " G64";
+    }
+
     //report_util_gcode_modes_M();
     switch (gc_state.modal.program_flow) {
         case ProgramFlow::Running:
@@ -634,9 +638,13 @@ void report_realtime_status(Channel& channel) {
     if (InputFile::_progress.length()) {
         msg << "|" + InputFile::_progress;
     }
-#ifdef DEBUG_STEPPER_ISR
-    msg << "|ISRs:" << Stepper::isr_count;
-#endif
+    if (config->_stepping->_reportStats) {
+        auto stats = Stepper::read_stats();
+        // ISR average and maximum in ns, fewest queued segments, underruns
+        msg << "|Stp:" << Stepper::stats_ns(stats.isr_count ? stats.isr_total / stats.isr_count : 0) << ","
+            << Stepper::stats_ns(stats.isr_max) << "," << (stats.low_water == UINT32_MAX ? 0 : stats.low_water) << ","
+            << stats.underruns;
+    }
 #ifdef DEBUG_REPORT_HEAP
     msg << "|Heap:" << xPortGetFreeHeapSize();
 #endif
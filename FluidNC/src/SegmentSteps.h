@@ -0,0 +1,77 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  SegmentSteps.h - fixed-point conversion of a step segment's distance and time to whole steps
+  and a step period, kept free of machine state so that it can be checked and benchmarked on
+  the host against the floating point version it replaces.  That benchmark only times the host;
+  the ESP32 has no 64-bit divide instruction, so finish() calls a software divide there, and
+  the gain on the target has not been measured.
+*/
+
+#include <cstdint>
+
+// Steps are only executed whole, so the end of every segment leaves a partial step whose time is
+// carried into the next segment, keeping the step output exact.  Distances within a segment are
+// Q16 steps and times are Q16 timer ticks, fine enough that the carried time does not drift over
+// a long move.  The whole steps left in the block are an integer and are not rounded again from
+// segment to segment, but each segment still starts from a float distance, the product of
+// step_per_mm and mm_remaining in prep_buffer(), which has float precision on very long moves.
+struct SegmentSteps {
+    static const int step_shift = 16;
+    static const int tick_shift = 16;
+
+    uint32_t steps_remaining;  // Whole steps left in the block before the segment
+    uint64_t dt_remainder;     // Time to execute the partial step of the last segment, Q16 timer ticks
+
+    // The segment being prepared
+    uint32_t next_steps_remaining;  // Whole steps left after the segment
+    uint32_t segment_distance;      // Distance of the segment including the carried partial step, Q16 steps
+    uint32_t partial_step;          // Partial step left at the end of the segment, Q16 steps
+
+    uint64_t period;  // Exact step period of the last segment finished, Q16 timer ticks
+
+    void start(uint32_t step_event_count) {
+        steps_remaining = step_event_count;
+        dt_remainder    = 0;
+    }
+
+    // Sets up a segment that ends step_dist_remaining steps from the end of the block.
+    // Returns the number of whole steps in it.
+    uint32_t segment_steps(float step_dist_remaining) {
+        uint32_t whole = uint32_t(step_dist_remaining);
+        uint32_t frac  = uint32_t((step_dist_remaining - float(whole)) * float(1 << step_shift));
+        // Round up.  Comparing the floats rather than testing frac keeps fractions below Q16
+        // resolution from rounding down.
+        next_steps_remaining = float(whole) < step_dist_remaining ? whole + 1 : whole;
+        segment_distance     = ((steps_remaining - whole) << step_shift) - frac;
+        partial_step         = ((next_steps_remaining - whole) << step_shift) - frac;
+        return steps_remaining - next_steps_remaining;
+    }
+
+    // Completes the segment set up by segment_steps(), which takes dt timer ticks.
+    // Returns the step period in timer ticks, rounded up and saturated at UINT32_MAX, and leaves
+    // the exact period in period.
+    uint32_t finish(float dt_ticks) {
+        uint64_t dt = uint64_t(dt_ticks * float(1 << tick_shift)) + dt_remainder;
+        // A segment of zero length only happens at the very end of a block; give it the longest
+        // period, as the float version's division by zero did.  Steps more than a few minutes apart
+        // do not need fractions of a tick, and would overflow computing them.
+        if (!segment_distance) {
+            period = UINT64_MAX;
+        } else if (dt >> (64 - step_shift)) {
+            period = (dt / segment_distance) << step_shift;
+        } else {
+            period = (dt << step_shift) / segment_distance;
+        }
+        if (period >> (64 - step_shift)) {
+            dt_remainder = uint64_t(partial_step) * (period >> step_shift);
+        } else {
+            dt_remainder = (uint64_t(partial_step) * period) >> step_shift;
+        }
+        steps_remaining = next_steps_remaining;
+        uint64_t ticks  = (period >> tick_shift) + ((period & ((1 << tick_shift) - 1)) != 0);
+        return ticks > UINT32_MAX ? UINT32_MAX : uint32_t(ticks);
+    }
+};
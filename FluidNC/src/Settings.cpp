@@ -5,6 +5,7 @@
 #include "WebUI/Commands.h"     // WebUI::COMMANDS
 #include "System.h"             // sys
 #include "Protocol.h"           // protocol_buffer_synchronize
+#include "MotionControl.h"      // mc_start_held_motion
 #include "Machine/MachineConfig.h"
 
 #include <map>
@@ -66,6 +67,7 @@ Setting::Setting(const char* description, type_t type, permissions_t permissions
 }
 
 Error Setting::check_state() {
+    mc_start_held_motion();
     if (notIdleOrAlarm()) {
         return Error::IdleError;
     }
@@ -381,6 +383,9 @@ void EnumSetting::addWebui(WebUI::JSONencoder* j) {
 }
 
 Error UserCommand::action(const char* value, WebUI::AuthenticationLevel auth_level, Channel& out) {
+    if (_cmdChecker && _cmdChecker != anyState) {
+        mc_start_held_motion();
+    }
     if (_cmdChecker && _cmdChecker()) {
         return Error::IdleError;
     }
@@ -15,8 +15,14 @@
 #include "StepperPrivate.h"
 #include "Planner.h"
 #include "Protocol.h"
+#include "InputShaper.h"
+#include "SegmentSteps.h"
+#include "Driver/delay_usecs.h"  // getCpuTicks
 #include <esp_attr.h>  // IRAM_ATTR
+#include <cstddef>     // offsetof
 #include <cmath>
+#include <atomic>
+#include <algorithm>
 
 using namespace Stepper;
 
@@ -24,17 +30,23 @@ static bool awake = false;
 
 // Stores the planner block Bresenham algorithm execution data for the segments in the segment
 // buffer. Normally, this buffer is partially in-use, but, for the worst case scenario, it will
-// never exceed the number of accessible stepper buffer segments (config->_stepping->_segments-1).
+// never exceed the number of accessible stepper buffer segments (config->_stepping->_segments).
 // NOTE: This data is copied from the prepped planner blocks so that the planner blocks may be
 // discarded when entirely consumed and completed by the segment buffer. Also, AMASS alters this
 // data for its own use.
+// NOTE: Like planner blocks, these are allocated with room for the configured axes only, so steps[]
+// must stay last.
 struct st_block_t {
-    uint32_t steps[MAX_N_AXIS];
     uint32_t step_event_count;
     uint8_t  direction_bits;
     bool     is_pwm_rate_adjusted;  // Tracks motions that require constant laser power/rate
+    uint8_t  train_max;             // Most step events per pulse train, or 0 to step event by event
+    uint32_t steps[MAX_N_AXIS];
 };
-static volatile st_block_t* st_block_buffer = nullptr;
+static uint8_t* st_block_buffer = nullptr;
+static size_t   st_block_size;  // Bytes per st_block_t with steps[] cut to the configured axes
+
+#define ST_BLOCK(index) (reinterpret_cast<volatile st_block_t*>(st_block_buffer + (index)*st_block_size))
 
 // Primary stepper segment ring buffer. Contains small, short line segments for the stepper
 // algorithm to execute, which are "checked-out" incrementally from the first block in the
@@ -45,20 +57,111 @@ struct segment_t {
     uint16_t     isrPeriod;          // Time to next ISR tick, in units of timer ticks
     uint8_t      st_block_index;     // Stepper block data index. Uses this information to execute this segment.
     uint8_t      amass_level;        // AMASS level for the ISR to execute this segment
+    uint16_t     isrPeriodFrac;      // Fraction of a timer tick to add to isrPeriod, in 1/65536ths
     uint32_t     spindle_dev_speed;  // Spindle speed scaled to the device
     SpindleSpeed spindle_speed;      // Spindle speed in GCode units
 };
 static segment_t* segment_buffer = nullptr;
 
+// Step segment ring buffer indices.  The ring has a single producer, prep_buffer(), which only
+// advances the head, and a single consumer, pulse_func(), which only advances the tail, so it needs
+// no lock even with the two on different cores.  The indices run free and are masked into the
+// buffer, whose size is a power of two; the difference between them is the number of segments
+// queued.  Each side publishes with a release store and reads the other side's index with an
+// acquire load, so a segment is complete before the ISR can see it, and the ISR is done with a
+// segment before prep_buffer() can overwrite it.
+static std::atomic<uint32_t> segment_buffer_tail;
+static std::atomic<uint32_t> segment_buffer_head;
+static uint32_t              segment_buffer_mask;
+
+// Segment times from stepping/acceleration_ticks_per_sec and cruise_ticks_per_sec (min/segment)
+static float dt_segment;
+static float dt_cruise;
+
+template <int N>
+static inline bool pulse_axes();
+template <int N>
+static bool timed_pulse();
+
+bool            Stepper::prep_in_task = false;
+static uint32_t prep_low_water;  // The ISR wakes the prep task when no more segments than this are queued
+
+// The underrun guard; see guard_underrun()
+static uint32_t guard_segments;  // Fewer queued than this means the buffer is running low
+static uint32_t guard_down_at;   // The scale may be lowered again once head reaches this
+static int32_t  guard_up_time;   // And raised once getCpuTicks() reaches this without running low
+
+static const int32_t guard_up_us = 1000000;  // How long the buffer must stay healthy for each raise
+
+// Body of the prep task.  Like the protocol loop, it only preps segments while motion is underway.
+static void prep_task() {
+    switch (sys.state) {
+        case State::Cycle:
+        case State::Homing:
+        case State::Hold:
+        case State::Jog:
+        case State::SafetyDoor:
+            Stepper::prep_buffer();
+            break;
+        default:
+            break;
+    }
+}
+
 void Stepper::init() {
+    reset_stats();
+
+    dt_segment = 1.0f / (float(config->_stepping->_accelerationTicks) * 60.0f);
+    dt_cruise  = 1.0f / (float(config->_stepping->_cruiseTicks) * 60.0f);
+
     if (st_block_buffer) {
         delete[] st_block_buffer;
     }
-    st_block_buffer = new st_block_t[config->_stepping->_segments - 1];
+    st_block_size   = offsetof(st_block_t, steps) + config->_axes->_numberAxis * sizeof(uint32_t);
+    st_block_buffer = new uint8_t[config->_stepping->_segments * st_block_size];
     if (segment_buffer) {
         delete[] segment_buffer;
     }
-    segment_buffer = new segment_t[config->_stepping->_segments];
+    uint32_t size = 1;
+    while (size < config->_stepping->_segments) {
+        size <<= 1;
+    }
+    segment_buffer      = new segment_t[size];
+    segment_buffer_mask = size - 1;
+
+    // Only time the ISR when the times are reported
+    bool timed = config->_stepping->_reportStats;
+    switch (config->_axes->_numberAxis) {
+        case 3:
+            pulse_func = timed ? timed_pulse<3> : pulse_axes<3>;
+            break;
+        case 4:
+            pulse_func = timed ? timed_pulse<4> : pulse_axes<4>;
+            break;
+        case 6:
+            pulse_func = timed ? timed_pulse<6> : pulse_axes<6>;
+            break;
+        default:
+            pulse_func = timed ? timed_pulse<0> : pulse_axes<0>;
+            break;
+    }
+
+    if (config->_stepping->_prepTask) {
+        prep_low_water = config->_stepping->_segments / 2;
+        prep_in_task   = prep_task_start(prep_task, SUPPORT_TASK_CORE, PREP_TASK_PRIORITY, 1000 / config->_stepping->_accelerationTicks);
+        if (!prep_in_task) {
+            log_warn("Cannot start the prep task; segments will be prepped by the protocol loop");
+        }
+    }
+
+    // Keep the guard below the point where the prep task is woken, or below a full buffer without
+    // the task, or it would always fire
+    uint32_t guard_max = prep_in_task ? prep_low_water : config->_stepping->_segments;
+    guard_segments     = (config->_stepping->_underrunGuardMs * config->_stepping->_accelerationTicks + 999) / 1000;
+    if (guard_segments >= guard_max) {
+        guard_segments = guard_max - 1;
+        log_warn("Reducing stepping/underrun_guard_ms to " << guard_segments * 1000 / config->_stepping->_accelerationTicks);
+    }
 }
 
 // Stepper ISR data struct. Contains the running data for the main stepper ISR.
@@ -74,17 +177,16 @@ typedef struct {
     uint32_t steps[MAX_N_AXIS];
 
     uint16_t             step_count;        // Steps remaining in line segment motion
+    uint8_t              train_max;         // Most step events per pulse train in the segment, or 0
+    bool                 slot_used;         // The last ISR computed a step event, which this one outputs
+    uint16_t             period_phase;      // Accumulated fractions of isrPeriodFrac, in 1/65536ths of a tick
+    uint32_t             timer_period;      // Period the step timer is set to, 0 if unknown
     uint8_t              exec_block_index;  // Tracks the current st_block index. Change indicates new block.
     volatile st_block_t* exec_block;        // Pointer to the block data for the segment being executed
     volatile segment_t*  exec_segment;      // Pointer to the segment being executed
 } stepper_t;
 static stepper_t st;
 
-// Step segment ring buffer indices
-static volatile uint32_t segment_buffer_tail;
-static volatile uint32_t segment_buffer_head;
-static uint32_t          segment_next_head;
-
 // Pointers for the step segment being prepped from the planner buffer. Accessed only by the
 // main program. Pointers may be planning segments or planner blocks ahead of what being executed.
 static plan_block_t*        pl_block;       // Pointer to the planner block being prepped
@@ -96,15 +198,13 @@ typedef struct {
     uint8_t  st_block_index;  // Index of stepper common data block being prepped
     PrepFlag recalculate_flag;
 
-    float dt_remainder;
-    float steps_remaining;
-    float step_per_mm;
-    float req_mm_increment;
+    SegmentSteps steps;  // Whole steps left in the block and the carried partial step time
+    float        step_per_mm;
+    float        req_mm_increment;
 
-    uint8_t last_st_block_index;
-    float   last_steps_remaining;
-    float   last_step_per_mm;
-    float   last_dt_remainder;
+    uint8_t      last_st_block_index;
+    SegmentSteps last_steps;
+    float        last_step_per_mm;
 
     uint8_t ramp_type;    // Current segment ramp state
     float   mm_complete;  // End of velocity profile from end of current planner block in (mm).
@@ -118,9 +218,95 @@ typedef struct {
     float        inv_rate;  // Used by PWM laser mode to speed up segment calculations.
     SpindleSpeed current_spindle_speed;
 
+    // Shaped ramp state. Only used when smooth_ramps is enabled or the block has an input shaper.
+    float ramp_start_speed;  // Speed at the start of the current ramp (mm/min)
+    float ramp_delta_speed;  // Speed change over the whole ramp (mm/min)
+    float ramp_duration;     // Duration of the ramp (min)
+    float ramp_elapsed;      // Time into the ramp at the end of the segment buffer (min)
+    float ramp_carry;        // S-curve slope at the start of the ramp, relative to ramp_delta_speed / ramp_duration
+    bool  ramp_smooth;       // The current ramp is not constant-acceleration
+    float carry_accel;       // Acceleration when the block was replanned mid-ramp (mm/min^2)
+
+    const InputShaper* shaper;  // Input shaper of the block's dominant axis, or nullptr
+    ShapedRamp         shaped;  // Current ramp, if it is input shaped
 } st_prep_t;
 static st_prep_t prep;
 
+// Begins a ramp from the current speed to target_speed, taking the same time as a
+// constant-acceleration ramp would.  An S-curve ramp starts at carry_accel, so that a replan
+// does not drop the acceleration to zero, unless that would exceed the peak or oppose the ramp.
+static void start_ramp(float target_speed, float acceleration, float carry_accel = 0.0f) {
+    prep.ramp_start_speed = prep.current_speed;
+    prep.ramp_delta_speed = target_speed - prep.current_speed;
+    prep.ramp_duration    = fabsf(prep.ramp_delta_speed) / acceleration;
+    prep.ramp_elapsed     = 0.0f;
+    prep.ramp_carry       = 0.0f;
+    if (prep.ramp_delta_speed != 0.0f) {
+        prep.ramp_carry = std::clamp(carry_accel * prep.ramp_duration / prep.ramp_delta_speed, 0.0f, sCurvePeakRatio);
+    }
+
+    // A ramp too short for the shaper falls back to the S-curve or a constant-acceleration ramp.
+    if (prep.shaper && ShapedRamp::fits(*prep.shaper, prep.ramp_duration)) {
+        prep.shaped = { prep.shaper, prep.ramp_start_speed, prep.ramp_delta_speed, prep.ramp_duration };
+    } else {
+        prep.shaped.shaper = nullptr;
+    }
+    prep.ramp_smooth = prep.shaped.shaper || config->_smoothRamps;
+}
+
+// The S-curve follows the quintic blend 10u^3 - 15u^4 + 6u^5 of the normalized ramp time u,
+// so acceleration and jerk are both zero at either end of the ramp. Its integral over the
+// ramp is 1/2, the same as a linear ramp, so the planner's ramp distances remain exact.
+// Its slope peaks at sCurvePeakRatio halfway through.  A ramp that starts with slope c adds
+// c * u(1-u)^3(1-3u), whose integral is zero, and its slope stays within sCurvePeakRatio
+// for c from 0 to sCurvePeakRatio.  An input-shaped ramp takes precedence over the S-curve.
+static float ramp_speed(float t) {
+    if (prep.shaped.shaper) {
+        return prep.shaped.speed(t);
+    }
+    float u  = t / prep.ramp_duration;
+    float v  = 1.0f - u;
+    float du = u * u * u * (10.0f + u * (6.0f * u - 15.0f)) + prep.ramp_carry * u * v * v * v * (1.0f - 3.0f * u);
+    return prep.ramp_start_speed + prep.ramp_delta_speed * du;
+}
+
+// Distance traveled from the start of the ramp to time t
+static float ramp_distance(float t) {
+    if (prep.shaped.shaper) {
+        return prep.shaped.distance(t);
+    }
+    float u  = t / prep.ramp_duration;
+    float v  = 1.0f - u;
+    float su = u * u * u * u * (2.5f + u * (u - 3.0f)) + prep.ramp_carry * 0.5f * u * u * v * v * v * v;
+    return t * prep.ramp_start_speed + prep.ramp_delta_speed * prep.ramp_duration * su;
+}
+
+// Acceleration of the S-curve at time t into the ramp (mm/min^2)
+static float ramp_acceleration(float t) {
+    float u = t / prep.ramp_duration;
+    float v = 1.0f - u;
+    return prep.ramp_delta_speed / prep.ramp_duration * v * v * (30.0f * u * u + prep.ramp_carry * (1.0f + u * (15.0f * u - 10.0f)));
+}
+
+// Advances the smooth ramp by time_var, updating mm_remaining and the current speed.
+// If the ramp ends at end_mm within that time, returns false and sets time_var to
+// the time left in the ramp instead.
+static bool advance_ramp(float& time_var, float& mm_remaining, float end_mm) {
+    float ramp_time = prep.ramp_elapsed + time_var;
+    if (ramp_time < prep.ramp_duration) {
+        float mm_var = mm_remaining - (ramp_distance(ramp_time) - ramp_distance(prep.ramp_elapsed));
+        if (mm_var > end_mm) {
+            mm_remaining       = mm_var;
+            prep.current_speed = ramp_speed(ramp_time);
+            prep.ramp_elapsed  = ramp_time;
+            return true;
+        }
+    }
+    time_var          = prep.ramp_duration - prep.ramp_elapsed;
+    prep.ramp_elapsed = prep.ramp_duration;
+    return false;
+}
+
 /* "The Stepper Driver Interrupt" - This timer interrupt is the workhorse, employing
    the venerable Bresenham line algorithm to manage and exactly synchronize multi-axis moves.
    Unlike the popular DDA algorithm, the Bresenham algorithm is not susceptible to numerical
@@ -177,13 +363,115 @@ static st_prep_t prep;
 
 // Stepper shutdown
 void IRAM_ATTR Stepper::stop_stepping() {
+    config->_axes->stop_bursts();
     config->_axes->unstep();
     st.step_outbits = 0;
+    st.timer_period = 0;
+    st.slot_used    = false;
 }
 
-#ifdef DEBUG_STEPPER_ISR
-uint32_t Stepper::isr_count;  // for debugging only
-#endif
+Stepper::Stats Stepper::stats;
+
+// Odd while timed_pulse() updates the ISR times in stats, so that read_stats() on the other core
+// can tell when its copy of the 64-bit isr_total may be torn.
+static std::atomic<uint32_t> stats_seq;
+
+// Set by prep_buffer() when it leaves the buffer full with more to prep, and cleared when it runs
+// out of planner blocks, so that the ISR can tell an underrun from the end of a motion.
+static volatile bool prep_pending = false;
+
+// The underrun guard compares the segments queued when prep_buffer() is entered with the number
+// that stepping/underrun_guard_ms amounts to.  Slower motion costs less ISR time, leaving more for
+// segment prep and the protocol loop.  The speed is given back a little at a time, once for every
+// guard_up_us that the buffer stays healthy.  Segment counts are kept in terms of
+// segment_buffer_head, which counts every segment prepped since the last reset.
+static void guard_underrun() {
+    if (!guard_segments || !prep_pending) {
+        return;
+    }
+    uint32_t head   = segment_buffer_head.load(std::memory_order_relaxed);
+    uint32_t queued = head - segment_buffer_tail.load(std::memory_order_acquire);
+    int      scale  = sys.underrun_scale;
+    if (queued < guard_segments) {
+        guard_up_time = usToEndTicks(guard_up_us);
+        if (int32_t(head - guard_down_at) >= 0 && scale > UnderrunScale::Min) {
+            // Give the new speed a buffer's worth of segments to take effect
+            guard_down_at = head + config->_stepping->_segments;
+            protocol_send_event(&underrunScaleEvent, std::max(scale - UnderrunScale::Decrement, UnderrunScale::Min));
+        }
+    } else if (scale < UnderrunScale::Default && int32_t(getCpuTicks() - guard_up_time) >= 0) {
+        guard_up_time = usToEndTicks(guard_up_us);
+        protocol_send_event(&underrunScaleEvent, std::min(scale + UnderrunScale::Increment, UnderrunScale::Default));
+    }
+}
+
+void Stepper::reset_stats() {
+    stats = {};
+    stats.isr_min         = UINT32_MAX;
+    stats.low_water       = UINT32_MAX;
+    stats.min_step_period = UINT32_MAX;
+}
+
+Stepper::Stats Stepper::read_stats() {
+    Stats    copy;
+    uint32_t seq;
+    do {
+        seq  = stats_seq.load(std::memory_order_acquire);
+        copy = stats;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != stats_seq.load(std::memory_order_relaxed));
+    return copy;
+}
+
+uint32_t Stepper::stats_ns(uint64_t ticks) {
+    return uint32_t(ticks * 1000000 / usToCpuTicks(1000));
+}
+
+// The longest window of step events for one pulse train, so that times within it, in 1/65536ths of
+// a timer tick, fit in 32 bits.  It also keeps the gaps within the 15 bits of an RMT item.
+static const uint32_t maxTrainTicks = 0xffff;
+
+// The most step events in one window, and the step times of one axis' train over it
+static const uint32_t maxTrainEvents = 64;
+static uint32_t       train_times[maxTrainEvents];
+
+// Hands the next events step events of the segment to the motors as one pulse train per axis,
+// instead of tracing them event by event.  The counter of each axis is advanced over the window
+// in closed form, and its steps fall every step_event_count / steps[axis] events, with the
+// remainder carried from step to step, so the steps land on exactly the events, and the counters
+// come out exactly as, the Bresenham loop would have them.  start is the fraction of a timer tick
+// at which the window begins.
+static inline void IRAM_ATTR step_trains(int n_axis, uint32_t events, uint32_t start) {
+    uint32_t period = (uint32_t(st.exec_segment->isrPeriod) << 16) | st.exec_segment->isrPeriodFrac;
+    uint32_t sec    = st.exec_block->step_event_count;
+    for (int axis = 0; axis < n_axis; axis++) {
+        uint32_t steps = st.steps[axis];
+        if (steps == 0) {
+            continue;
+        }
+        uint32_t counter = st.counter[axis];
+        uint32_t total   = counter + events * steps;
+        uint32_t n       = (total - 1) / sec;
+        if (n) {
+            // The first step is at the event where the counter passes step_event_count
+            uint32_t event    = (sec - counter) / steps;
+            uint32_t rem      = (sec - counter) % steps;
+            uint32_t interval = sec / steps;
+            uint32_t extra    = sec % steps;
+            for (uint32_t i = 0; i < n; i++) {
+                train_times[i] = (event * period + start) >> 16;
+                event += interval;
+                rem += extra;
+                if (rem >= steps) {
+                    rem -= steps;
+                    event++;
+                }
+            }
+            config->_axes->step_burst(axis, train_times, n, bitnum_is_true(st.dir_outbits, axis));
+        }
+        st.counter[axis] = total - n * sec;
+    }
+}
 
 /**
  * This phase of the ISR should ONLY create the pulses for the steppers.
@@ -192,38 +480,51 @@ uint32_t Stepper::isr_count;  // for debugging only
  * call to this method that might cause variation in the timing. The aim
  * is to keep pulse timing as regular as possible.
  * Returns true if step interrupts should continue
+ *
+ * N is the number of axes, so that the compiler can unroll the Bresenham loops for the
+ * common machines.  N = 0 handles any number of axes, read from the config.
  */
-bool IRAM_ATTR Stepper::pulse_func() {
-#ifdef DEBUG_STEPPER_ISR
-    isr_count++;
-#endif
+template <int N>
+static inline bool IRAM_ATTR pulse_axes() {
     // This is a precaution in case we get a spurious interrupt
     if (!awake) {
         return false;
     }
-    auto n_axis = config->_axes->_numberAxis;
+    const int n_axis = N ? N : config->_axes->_numberAxis;
 
     config->_axes->step(st.step_outbits, st.dir_outbits);
 
     // If there is no step segment, attempt to pop one from the stepper buffer
     if (st.exec_segment == NULL) {
         // Anything in the buffer? If so, load and initialize next step segment.
-        if (segment_buffer_head != segment_buffer_tail) {
+        uint32_t tail = segment_buffer_tail.load(std::memory_order_relaxed);
+        if (segment_buffer_head.load(std::memory_order_acquire) != tail) {
             // Initialize new step segment and load number of steps to execute
-            st.exec_segment = &segment_buffer[segment_buffer_tail];
-            // Initialize step segment timing per step and load number of steps to execute.
-            config->_stepping->setTimerPeriod(st.exec_segment->isrPeriod);
+            st.exec_segment = &segment_buffer[tail & segment_buffer_mask];
+            if (prep_pending) {
+                uint32_t queued = segment_buffer_head.load(std::memory_order_relaxed) - tail;
+                if (queued < stats.low_water) {
+                    stats.low_water = queued;
+                }
+            }
+            uint32_t step_period = uint32_t(st.exec_segment->isrPeriod) << st.exec_segment->amass_level;
+            if (step_period < stats.min_step_period) {
+                stats.min_step_period = step_period;
+            }
+            // Load number of steps to execute.
             st.step_count = st.exec_segment->n_step;  // NOTE: Can sometimes be zero when moving slow.
             // If the new segment starts a new planner block, initialize stepper variables and counters.
             // NOTE: When the segment data index changes, this indicates a new planner block.
             if (st.exec_block_index != st.exec_segment->st_block_index) {
                 st.exec_block_index = st.exec_segment->st_block_index;
-                st.exec_block       = &st_block_buffer[st.exec_block_index];
+                st.exec_block       = ST_BLOCK(st.exec_block_index);
                 // Initialize Bresenham line and distance counters
                 for (int axis = 0; axis < n_axis; axis++) {
                     st.counter[axis] = st.exec_block->step_event_count >> 1;
                 }
             }
+            // AMASS interleaves ISRs without steps, which the closed form in step_trains() would skip
+            st.train_max = st.exec_segment->amass_level == 0 ? st.exec_block->train_max : 0;
 
             st.dir_outbits = st.exec_block->direction_bits;
             // Adjust Bresenham axis increment counters according to AMASS level.
@@ -234,6 +535,9 @@ bool IRAM_ATTR Stepper::pulse_func() {
             spindle->setSpeedfromISR(st.exec_segment->spindle_dev_speed);
         } else {
             // Segment buffer empty. Shutdown.
+            if (prep_pending && !sys.step_control.endMotion) {
+                stats.underruns++;
+            }
             stop_stepping();
             if (!state_is(State::Jog)) {  // added to prevent ... jog after probing crash
                 // Ensure pwm is set properly upon completion of rate-controlled motion.
@@ -259,29 +563,101 @@ bool IRAM_ATTR Stepper::pulse_func() {
         protocol_send_event_from_ISR(&motionCancelEvent);
     }
 #endif
+    // In segments that are stepped in pulse trains, each ISR hands a window of step events to
+    // step_trains() and lasts as long as the window.  If the last ISR computed a step the usual
+    // way, it went out at the top of this one, which then only lets its time pass, because
+    // restarting a channel would cut the pulse short.  The last event of a segment is always
+    // computed the usual way, by the ISR of its last window, so that it goes out one period after
+    // the trains whether the next segment is stepped in trains or event by event.
+    bool     drain  = false;
+    uint32_t events = 0;
+    if (st.train_max) {
+        if (st.slot_used) {
+            st.slot_used = false;
+            drain        = true;
+        } else {
+            events = std::min(uint32_t(st.step_count), uint32_t(st.train_max));
+            events = std::min(events, std::max(maxTrainTicks / (st.exec_segment->isrPeriod + 1), uint32_t(1)));
+            if (events && events == st.step_count) {
+                events--;
+            }
+        }
+    }
+
+    // Dither the timer period between isrPeriod and isrPeriod + 1 so that it averages out to the
+    // exact step period.  The phase carries over from segment to segment, so the rounding of one
+    // segment is made up in the next, and the timer is only written when the period changes.
+    uint32_t start  = st.period_phase;
+    uint32_t slots  = events ? events : 1;
+    uint32_t phase  = start + uint32_t(st.exec_segment->isrPeriodFrac) * slots;
+    st.period_phase = uint16_t(phase);
+    uint32_t period = uint32_t(st.exec_segment->isrPeriod) * slots + (phase >> 16);
+    if (period != st.timer_period) {
+        st.timer_period = period;
+        config->_stepping->setTimerPeriod(period);
+    }
+
     // Reset step out bits.
     st.step_outbits = 0;
 
-    for (int axis = 0; axis < n_axis; axis++) {
-        // Execute step displacement profile by Bresenham line algorithm
-        st.counter[axis] += st.steps[axis];
-        if (st.counter[axis] > st.exec_block->step_event_count) {
-            set_bitnum(st.step_outbits, axis);
-            st.counter[axis] -= st.exec_block->step_event_count;
+    if (events) {
+        // The top of the ISR set the direction pins for the last segment; this one may be a new
+        // block.  The first item of each train waits out the direction delay.
+        config->_axes->set_direction(st.dir_outbits);
+        step_trains(n_axis, events, start);
+        st.step_count -= events;
+    }
+    if (!drain && (!st.train_max || st.step_count == 1)) {
+        for (int axis = 0; axis < n_axis; axis++) {
+            // Execute step displacement profile by Bresenham line algorithm
+            st.counter[axis] += st.steps[axis];
+            if (st.counter[axis] > st.exec_block->step_event_count) {
+                set_bitnum(st.step_outbits, axis);
+                st.counter[axis] -= st.exec_block->step_event_count;
+            }
         }
+        st.step_count--;  // Decrement step events count
+        st.slot_used = true;
     }
 
-    st.step_count--;  // Decrement step events count
     if (st.step_count == 0) {
         // Segment is complete. Discard current segment and advance segment indexing.
-        st.exec_segment     = NULL;
-        segment_buffer_tail = segment_buffer_tail >= (config->_stepping->_segments - 1) ? 0 : segment_buffer_tail + 1;
+        st.exec_segment = NULL;
+        uint32_t tail   = segment_buffer_tail.load(std::memory_order_relaxed) + 1;
+        segment_buffer_tail.store(tail, std::memory_order_release);
+        if (prep_in_task && segment_buffer_head.load(std::memory_order_relaxed) - tail <= prep_low_water) {
+            prep_task_wake();
+        }
     }
 
     config->_axes->unstep();
     return true;
 }
 
+// The ISR proper, with its run time measured.  getCpuTicks() is a function call, so this adds
+// two calls and the bookkeeping to every ISR; init() only uses it with stepping/report_stats.
+template <int N>
+static bool IRAM_ATTR timed_pulse() {
+    int32_t  start = getCpuTicks();
+    bool     more  = pulse_axes<N>();
+    uint32_t ticks = getCpuTicks() - start;
+    uint32_t seq   = stats_seq.load(std::memory_order_relaxed);
+    stats_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    stats.isr_count++;
+    stats.isr_total += ticks;
+    if (ticks < stats.isr_min) {
+        stats.isr_min = ticks;
+    }
+    if (ticks > stats.isr_max) {
+        stats.isr_max = ticks;
+    }
+    stats_seq.store(seq + 2, std::memory_order_release);
+    return more;
+}
+
+bool (*Stepper::pulse_func)() = timed_pulse<0>;
+
 // enabled. Startup init and limits call this function but shouldn't start the cycle.
 void Stepper::wake_up() {
     if (awake) {
@@ -305,6 +681,7 @@ void Stepper::go_idle() {
 
 // Reset and clear stepper subsystem variables
 void Stepper::reset() {
+    PrepLock lock;
     // Initialize Stepping driver idle state.
     config->_stepping->reset();
 
@@ -313,19 +690,29 @@ void Stepper::reset() {
     // Initialize stepper algorithm variables.
     memset(&prep, 0, sizeof(st_prep_t));
     memset(&st, 0, sizeof(stepper_t));
-    st.exec_segment     = NULL;
-    pl_block            = NULL;  // Planner block pointer used by segment buffer
-    segment_buffer_tail = 0;
-    segment_buffer_head = 0;  // empty = tail
-    segment_next_head   = 1;
-    st.step_outbits     = 0;
-    st.dir_outbits      = 0;  // Initialize direction bits to default.
+    st.exec_segment = NULL;
+    pl_block        = NULL;  // Planner block pointer used by segment buffer
+    prep_pending    = false;
+    guard_down_at   = 0;
+    guard_up_time   = getCpuTicks();
+    segment_buffer_tail.store(0, std::memory_order_relaxed);
+    segment_buffer_head.store(0, std::memory_order_relaxed);  // empty = tail
+    st.step_outbits = 0;
+    st.dir_outbits  = 0;  // Initialize direction bits to default.
     // TODO do we need to turn step pins off?
 }
 
 // Called by planner_recalculate() when the executing block is updated by the new plan.
 bool Stepper::update_plan_block_parameters() {
+    PrepLock lock;
     if (pl_block != NULL) {  // Ignore if at start of a new block.
+        // The new profile starts its first ramp from the current speed; an S-curve also continues
+        // from the current acceleration.
+        prep.carry_accel = 0.0f;
+        if (prep.ramp_smooth && !prep.shaped.shaper && (prep.ramp_type == RAMP_ACCEL || prep.ramp_type == RAMP_DECEL) &&
+            prep.ramp_elapsed < prep.ramp_duration) {
+            prep.carry_accel = ramp_acceleration(prep.ramp_elapsed);
+        }
         prep.recalculate_flag.recalculate = 1;
         pl_block->entry_speed_sqr         = prep.current_speed * prep.current_speed;  // Update entry speed.
         pl_block                          = NULL;  // Flag prep_segment() to load and check active velocity profile.
@@ -336,11 +723,11 @@ bool Stepper::update_plan_block_parameters() {
 
 // Changes the run state of the step segment buffer to execute the special parking motion.
 void Stepper::parking_setup_buffer() {
+    PrepLock lock;
     // Store step execution data of partially completed block, if necessary.
     if (prep.recalculate_flag.holdPartialBlock) {
         prep.last_st_block_index  = prep.st_block_index;
-        prep.last_steps_remaining = prep.steps_remaining;
-        prep.last_dt_remainder    = prep.dt_remainder;
+        prep.last_steps           = prep.steps;
         prep.last_step_per_mm     = prep.step_per_mm;
     }
     // Set flags to execute a parking motion
@@ -351,12 +738,12 @@ void Stepper::parking_setup_buffer() {
 
 // Restores the step segment buffer to the normal run state after a parking motion.
 void Stepper::parking_restore_buffer() {
+    PrepLock lock;
     // Restore step execution data and flags of partially completed block, if necessary.
     if (prep.recalculate_flag.holdPartialBlock) {
-        st_prep_block                          = &st_block_buffer[prep.last_st_block_index];
+        st_prep_block                          = ST_BLOCK(prep.last_st_block_index);
         prep.st_block_index                    = prep.last_st_block_index;
-        prep.steps_remaining                   = prep.last_steps_remaining;
-        prep.dt_remainder                      = prep.last_dt_remainder;
+        prep.steps                             = prep.last_steps;
         prep.step_per_mm                       = prep.last_step_per_mm;
         prep.recalculate_flag.holdPartialBlock = 1;
         prep.recalculate_flag.recalculate      = 1;
@@ -371,7 +758,7 @@ void Stepper::parking_restore_buffer() {
 // Increments the step segment buffer block data ring buffer.
 static uint8_t next_block_index(uint8_t block_index) {
     block_index++;
-    return block_index == (config->_stepping->_segments - 1) ? 0 : block_index;
+    return block_index == config->_stepping->_segments ? 0 : block_index;
 }
 
 /* Prepares step segment buffer. Continuously called from main program.
@@ -388,12 +775,18 @@ static uint8_t next_block_index(uint8_t block_index) {
    NOTE: Computation units are in steps, millimeters, and minutes.
 */
 void Stepper::prep_buffer() {
+    PrepLock lock;
+
     // Block step prep buffer, while in a suspend state and there is no suspend motion to execute.
     if (sys.step_control.endMotion) {
         return;
     }
 
-    while (segment_buffer_tail != segment_next_head) {  // Check if we need to fill the buffer.
+    guard_underrun();
+
+    // Check if we need to fill the buffer.
+    while (segment_buffer_head.load(std::memory_order_relaxed) - segment_buffer_tail.load(std::memory_order_acquire) <
+           config->_stepping->_segments) {
         // Determine if we need to load a new planner block or if the block needs to be recomputed.
         if (pl_block == NULL) {
             // Query planner for a queued block
@@ -404,6 +797,7 @@ void Stepper::prep_buffer() {
             }
 
             if (pl_block == NULL) {
+                prep_pending = false;
                 return;  // No planner blocks. Exit.
             }
 
@@ -420,7 +814,7 @@ void Stepper::prep_buffer() {
                 // Prepare and copy Bresenham algorithm segment data from the new planner block, so that
                 // when the segment buffer completes the planner block, it may be discarded when the
                 // segment buffer finishes the prepped block, but the stepper ISR is still executing it.
-                st_prep_block                 = &st_block_buffer[prep.st_block_index];
+                st_prep_block                 = ST_BLOCK(prep.st_block_index);
                 st_prep_block->direction_bits = pl_block->direction_bits;
                 uint8_t idx;
                 auto    n_axis = config->_axes->_numberAxis;
@@ -433,11 +827,40 @@ void Stepper::prep_buffer() {
                 }
                 st_prep_block->step_event_count = pl_block->step_event_count << maxAmassLevel;
 
+                // Moves may be stepped in pulse trains if the motors of every moving axis can take
+                // them, but not homing, where motors are stopped individually, or probing, where the
+                // position must be known step by step.  The window is limited so that the closed-form
+                // counter arithmetic in step_trains() cannot overflow.
+                st_prep_block->train_max = 0;
+                if (!pl_block->motion.systemMotion && !probing) {
+                    uint32_t train_max = maxTrainEvents;
+                    for (idx = 0; idx < n_axis; idx++) {
+                        if (pl_block->steps[idx]) {
+                            train_max = std::min(train_max, config->_axes->_burstMax[idx]);
+                        }
+                    }
+                    if (st_prep_block->step_event_count <= UINT32_MAX / (train_max + 1)) {
+                        st_prep_block->train_max = train_max;
+                    }
+                }
+
+                // All axes share one step timeline, so the ramps of the block are shaped for the
+                // axis that travels the farthest.
+                prep.shaper  = nullptr;
+                float travel = 0.0f;
+                for (idx = 0; idx < n_axis; idx++) {
+                    auto  axis = config->_axes->_axis[idx];
+                    float mm   = pl_block->steps[idx] / axis->_stepsPerMm;
+                    if (mm > travel) {
+                        travel      = mm;
+                        prep.shaper = axis->_shaper.n_impulses ? &axis->_shaper : nullptr;
+                    }
+                }
+
                 // Initialize segment buffer data for generating the segments.
-                prep.steps_remaining  = (float)pl_block->step_event_count;
-                prep.step_per_mm      = prep.steps_remaining / pl_block->millimeters;
+                prep.steps.start(pl_block->step_event_count);  // Also resets the partial step time
+                prep.step_per_mm      = float(pl_block->step_event_count) / pl_block->millimeters;
                 prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR / prep.step_per_mm;
-                prep.dt_remainder     = 0.0;  // Reset for new segment block
                 if ((sys.step_control.executeHold) || prep.recalculate_flag.decelOverride) {
                     // New block loaded mid-hold. Override planner block entry speed to enforce deceleration.
                     prep.current_speed                  = prep.exit_speed;
@@ -466,6 +889,8 @@ void Stepper::prep_buffer() {
             */
             prep.mm_complete  = 0.0;  // Default velocity profile complete at 0.0mm from end of block.
             float inv_2_accel = 0.5f / pl_block->acceleration;
+            float carry_accel = prep.carry_accel;
+            prep.carry_accel  = 0.0f;
             if (sys.step_control.executeHold) {  // [Forced Deceleration to Zero Velocity]
                 // Compute velocity profile parameters for a feed hold in-progress. This profile overrides
                 // the planner block profile, enforcing a deceleration to zero speed.
@@ -479,6 +904,7 @@ void Stepper::prep_buffer() {
                     prep.mm_complete = decel_dist;  // End of feed hold.
                     prep.exit_speed  = 0.0;
                 }
+                start_ramp(prep.exit_speed, pl_block->acceleration, carry_accel);
             } else {  // [Normal Operation]
                 // Compute or recompute velocity profile parameters of the prepped planner block.
                 prep.ramp_type        = RAMP_ACCEL;  // Initialize as acceleration ramp.
@@ -541,38 +967,45 @@ void Stepper::prep_buffer() {
                     // prep.decelerate_after = 0.0;
                     prep.maximum_speed = prep.exit_speed;
                 }
+                if (prep.ramp_type == RAMP_ACCEL) {
+                    start_ramp(prep.maximum_speed, pl_block->acceleration, carry_accel);
+                } else if (prep.ramp_type == RAMP_DECEL) {
+                    start_ramp(prep.exit_speed, pl_block->acceleration, carry_accel);
+                }
             }
 
             sys.step_control.updateSpindleSpeed = true;  // Force update whenever updating block.
         }
 
         // Initialize new segment
-        volatile segment_t* prep_segment = &segment_buffer[segment_buffer_head];
+        volatile segment_t* prep_segment = &segment_buffer[segment_buffer_head.load(std::memory_order_relaxed) & segment_buffer_mask];
 
         // Set new segment to point to the current segment data block.
         prep_segment->st_block_index = prep.st_block_index;
 
         /*------------------------------------------------------------------------------------
             Compute the average velocity of this new segment by determining the total distance
-          traveled over the segment time DT_SEGMENT. The following code first attempts to create
+          traveled over the segment time dt_segment. The following code first attempts to create
           a full segment based on the current ramp conditions. If the segment time is incomplete
           when terminating at a ramp state change, the code will continue to loop through the
           progressing ramp states to fill the remaining segment execution time. However, if
           an incomplete segment terminates at the end of the velocity profile, the segment is
-          considered completed despite having a truncated execution time less than DT_SEGMENT.
+          considered completed despite having a truncated execution time less than dt_segment.
+            Segments that start cruising last dt_cruise instead, but end early where the cruise
+          ends, so that ramps are always traced at the finer resolution.
             The velocity profile is always assumed to progress through the ramp sequence:
           acceleration ramp, cruising state, and deceleration ramp. Each ramp's travel distance
           may range from zero to the length of the block. Velocity profiles can end either at
           the end of planner block (typical) or mid-block at the end of a forced deceleration,
           such as from a feed hold.
         */
-        float dt_max   = DT_SEGMENT;                                // Maximum segment time
-        float dt       = 0.0;                                       // Initialize segment time
-        float time_var = dt_max;                                    // Time worker variable
-        float mm_var;                                               // mm-Distance worker variable
-        float speed_var;                                            // Speed worker variable
-        float mm_remaining = pl_block->millimeters;                 // New segment distance from end of block.
-        float minimum_mm   = mm_remaining - prep.req_mm_increment;  // Guarantee at least one step.
+        float dt_max   = prep.ramp_type == RAMP_CRUISE ? dt_cruise : dt_segment;  // Maximum segment time
+        float dt       = 0.0;                                                     // Initialize segment time
+        float time_var = dt_max;                                                  // Time worker variable
+        float mm_var;                                                             // mm-Distance worker variable
+        float speed_var;                                                          // Speed worker variable
+        float mm_remaining = pl_block->millimeters;                               // New segment distance from end of block.
+        float minimum_mm   = mm_remaining - prep.req_mm_increment;                // Guarantee at least one step.
 
         if (minimum_mm < 0.0) {
             minimum_mm = 0.0;
@@ -596,20 +1029,28 @@ void Stepper::prep_buffer() {
                     break;
                 case RAMP_ACCEL:
                     // NOTE: Acceleration ramp only computes during first do-while loop.
-                    speed_var = pl_block->acceleration * time_var;
-                    mm_remaining -= time_var * (prep.current_speed + 0.5f * speed_var);
-                    if (mm_remaining < prep.accelerate_until) {  // End of acceleration ramp.
-                        // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
-                        mm_remaining = prep.accelerate_until;  // NOTE: 0.0 at EOB
-                        time_var     = 2.0f * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
-                        if (mm_remaining == prep.decelerate_after) {
-                            prep.ramp_type = RAMP_DECEL;
-                        } else {
-                            prep.ramp_type = RAMP_CRUISE;
+                    if (prep.ramp_smooth) {
+                        if (advance_ramp(time_var, mm_remaining, prep.accelerate_until)) {
+                            break;  // Acceleration only.
                         }
-                        prep.current_speed = prep.maximum_speed;
-                    } else {  // Acceleration only.
-                        prep.current_speed += speed_var;
+                    } else {
+                        speed_var = pl_block->acceleration * time_var;
+                        mm_remaining -= time_var * (prep.current_speed + 0.5f * speed_var);
+                        if (mm_remaining >= prep.accelerate_until) {  // Acceleration only.
+                            prep.current_speed += speed_var;
+                            break;
+                        }
+                        time_var = 2.0f * (pl_block->millimeters - prep.accelerate_until) / (prep.current_speed + prep.maximum_speed);
+                    }
+                    // End of acceleration ramp.
+                    // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
+                    mm_remaining       = prep.accelerate_until;  // NOTE: 0.0 at EOB
+                    prep.current_speed = prep.maximum_speed;
+                    if (mm_remaining == prep.decelerate_after) {
+                        prep.ramp_type = RAMP_DECEL;
+                        start_ramp(prep.exit_speed, pl_block->acceleration);
+                    } else {
+                        prep.ramp_type = RAMP_CRUISE;
                     }
                     break;
                 case RAMP_CRUISE:
@@ -622,24 +1063,34 @@ void Stepper::prep_buffer() {
                         time_var       = (mm_remaining - prep.decelerate_after) / prep.maximum_speed;
                         mm_remaining   = prep.decelerate_after;  // NOTE: 0.0 at EOB
                         prep.ramp_type = RAMP_DECEL;
+                        start_ramp(prep.exit_speed, pl_block->acceleration);
+                        if (dt_max > dt_segment) {
+                            dt_max = dt + time_var;  // End a long cruise segment where the ramp begins.
+                        }
                     } else {  // Cruising only.
                         mm_remaining = mm_var;
                     }
                     break;
                 default:  // case RAMP_DECEL:
-                    // NOTE: mm_var used as a misc worker variable to prevent errors when near zero speed.
-                    speed_var = pl_block->acceleration * time_var;  // Used as delta speed (mm/min)
-                    if (prep.current_speed > speed_var) {           // Check if at or below zero speed.
-                        // Compute distance from end of segment to end of block.
-                        mm_var = mm_remaining - time_var * (prep.current_speed - 0.5f * speed_var);  // (mm)
-                        if (mm_var > prep.mm_complete) {                                             // Typical case. In deceleration ramp.
-                            mm_remaining = mm_var;
-                            prep.current_speed -= speed_var;
-                            break;  // Segment complete. Exit switch-case statement. Continue do-while loop.
+                    if (prep.ramp_smooth) {
+                        if (advance_ramp(time_var, mm_remaining, prep.mm_complete)) {
+                            break;  // In deceleration ramp.
+                        }
+                    } else {
+                        // NOTE: mm_var used as a misc worker variable to prevent errors when near zero speed.
+                        speed_var = pl_block->acceleration * time_var;  // Used as delta speed (mm/min)
+                        if (prep.current_speed > speed_var) {           // Check if at or below zero speed.
+                            // Compute distance from end of segment to end of block.
+                            mm_var = mm_remaining - time_var * (prep.current_speed - 0.5f * speed_var);  // (mm)
+                            if (mm_var > prep.mm_complete) {  // Typical case. In deceleration ramp.
+                                mm_remaining = mm_var;
+                                prep.current_speed -= speed_var;
+                                break;  // Segment complete. Exit switch-case statement. Continue do-while loop.
+                            }
                         }
+                        time_var = 2.0f * (mm_remaining - prep.mm_complete) / (prep.current_speed + prep.exit_speed);
                     }
                     // Otherwise, at end of block or end of forced-deceleration.
-                    time_var           = 2.0f * (mm_remaining - prep.mm_complete) / (prep.current_speed + prep.exit_speed);
                     mm_remaining       = prep.mm_complete;
                     prep.current_speed = prep.exit_speed;
             }
@@ -651,7 +1102,7 @@ void Stepper::prep_buffer() {
                 if (mm_remaining > minimum_mm) {  // Check for very slow segments with zero steps.
                     // Increase segment time to ensure at least one step in segment. Override and loop
                     // through distance calculations until minimum_mm or mm_complete.
-                    dt_max += DT_SEGMENT;
+                    dt_max += dt_segment;
                     time_var = dt_max - dt;
                 } else {
                     break;  // **Complete** Exit loop. Segment execution time maxed.
@@ -693,11 +1144,11 @@ void Stepper::prep_buffer() {
            high step counts can exceed the precision of floats, which can lead to lost steps.
            Fortunately, this scenario is highly unlikely and unrealistic in typical DIY CNC
            machines (i.e. exceeding 10 meters axis travel at 200 step/mm).
+           step_dist_remaining is still a float, so this limit is unchanged; SegmentSteps only
+           does the rounding to whole steps and the rate computations in fixed point.
         */
-        float step_dist_remaining    = prep.step_per_mm * mm_remaining;                       // Convert mm_remaining to steps
-        float n_steps_remaining      = ceilf(step_dist_remaining);                            // Round-up current steps remaining
-        float last_n_steps_remaining = ceilf(prep.steps_remaining);                           // Round-up last steps remaining
-        prep_segment->n_step         = uint16_t(last_n_steps_remaining - n_steps_remaining);  // Compute number of steps to execute.
+        float step_dist_remaining = prep.step_per_mm * mm_remaining;                          // Convert mm_remaining to steps
+        prep_segment->n_step      = uint16_t(prep.steps.segment_steps(step_dist_remaining));  // Compute number of steps to execute.
 
         // Bail if we are at the end of a feed hold and don't have a step to execute.
         if (prep_segment->n_step == 0) {
@@ -721,14 +1172,12 @@ void Stepper::prep_buffer() {
         // typically very small and do not adversely effect performance, but ensures that the
         // system outputs the exact acceleration and velocity profiles computed by the planner.
 
-        dt += prep.dt_remainder;  // Apply previous segment partial step execute time
-        // dt is in minutes so inv_rate is in minutes
-        float inv_rate = dt / (last_n_steps_remaining - step_dist_remaining);  // Compute adjusted step rate inverse
-
-        // Compute CPU cycles per step for the prepped segment.
+        // Compute CPU cycles per step for the prepped segment, applying the previous segment's
+        // partial step execute time.
         // fStepperTimer is in units of timerTicks/sec, so the dimensional analysis is
         // timerTicks/sec * 60 sec/minute * minutes = timerTicks
-        uint32_t timerTicks = uint32_t(ceilf((Machine::Stepping::fStepperTimer * 60) * inv_rate));  // (timerTicks/step)
+        uint32_t timerTicks = prep.steps.finish((Machine::Stepping::fStepperTimer * 60.0f) * dt);  // (timerTicks/step)
+        uint64_t period     = prep.steps.period;                                                     // Exact, Q16 timerTicks
         int      level;
 
         // Compute step timing and multi-axis smoothing level.
@@ -737,22 +1186,25 @@ void Stepper::prep_buffer() {
                 break;
             }
             timerTicks >>= 1;
+            period >>= 1;
         }
         prep_segment->amass_level = level;
         prep_segment->n_step <<= level;
-        // isrPeriod is stored as 16 bits, so limit timerTicks to the
+        // isrPeriod is stored as 16 bits, so limit the period to the
         // largest value that will fit in a uint16_t.
-        prep_segment->isrPeriod = timerTicks > 0xffff ? 0xffff : timerTicks;
+        if ((period >> SegmentSteps::tick_shift) >= 0xffff) {
+            prep_segment->isrPeriod     = 0xffff;
+            prep_segment->isrPeriodFrac = 0;
+        } else {
+            prep_segment->isrPeriod     = uint16_t(period >> SegmentSteps::tick_shift);
+            prep_segment->isrPeriodFrac = uint16_t(period);
+        }
 
         // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
-        auto lastseg        = segment_next_head;
-        segment_next_head   = segment_next_head >= (config->_stepping->_segments - 1) ? 0 : segment_next_head + 1;
-        segment_buffer_head = lastseg;
+        segment_buffer_head.store(segment_buffer_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
 
         // Update the appropriate planner and segment data.
         pl_block->millimeters = mm_remaining;
-        prep.steps_remaining  = n_steps_remaining;
-        prep.dt_remainder     = (n_steps_remaining - step_dist_remaining) * inv_rate;
         // Check for exit conditions and flag to load next planner block.
         if (mm_remaining == prep.mm_complete) {
             // End of planner block or forced-termination. No more distance to be executed.
@@ -776,12 +1228,13 @@ void Stepper::prep_buffer() {
             }
         }
     }
+    prep_pending = true;  // The buffer is full
 }
 
 // Called by realtime status reporting to fetch the current speed being executed. This value
 // however is not exactly the current speed, but the speed computed in the last step segment
 // in the segment buffer. It will always be behind by up to the number of segment blocks (-1)
-// divided by the ACCELERATION TICKS PER SECOND in seconds.
+// divided by stepping/acceleration_ticks_per_sec in seconds.
 float Stepper::get_realtime_rate() {
     switch (sys.state) {
         case State::Cycle:
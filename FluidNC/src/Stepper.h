@@ -10,13 +10,15 @@
 */
 
 #include "EnumItem.h"
+#include "Driver/prep_task.h"
 
 #include <cstdint>
 
 namespace Stepper {
     void init();
 
-    bool pulse_func();
+    // The step ISR, specialized by init() for the number of axes
+    extern bool (*pulse_func)();
 
     // Enable steppers, but cycle does not start unless called by motion control or realtime command.
     void wake_up();
@@ -39,11 +41,39 @@ namespace Stepper {
     // Reloads step segment buffer. Called continuously by realtime execution system.
     void prep_buffer();
 
+    // True if segments are prepped by the prep task rather than the realtime execution system.
+    extern bool prep_in_task;
+
+    // Held while changing planner or segment generator state, which the prep task may be using.
+    struct PrepLock {
+        PrepLock() { prep_task_lock(); }
+        ~PrepLock() { prep_task_unlock(); }
+    };
+
     // Called by planner_recalculate() when the executing block is updated by the new plan.
     bool update_plan_block_parameters();
 
     // Called by realtime status reporting if realtime rate reporting is enabled in config.h.
     float get_realtime_rate();
 
-    extern uint32_t isr_count;
+    // Measurements of the step ISR and the segment buffer, to tune _segments and choose an
+    // engine from.  Times are in CPU ticks and step periods in step timer ticks.
+    struct Stats {
+        uint32_t isr_count;
+        uint32_t isr_min;
+        uint32_t isr_max;
+        uint64_t isr_total;
+        uint32_t low_water;        // Fewest segments queued while the segment generator had more to prep
+        uint32_t underruns;        // Times the segment buffer ran dry with more to prep
+        uint32_t min_step_period;  // Shortest step period of the dominant axis
+    };
+    extern Stats stats;
+
+    void reset_stats();
+
+    // A copy of stats whose ISR times are consistent even while the ISR updates them on the other core
+    Stats read_stats();
+
+    // Converts CPU ticks from stats to nanoseconds
+    uint32_t stats_ns(uint64_t ticks);
 }
@@ -5,20 +5,26 @@
 #include "Machine/MachineConfig.h"  // config
 
 #include <atomic>
+#include <algorithm>
+
+const EnumItem stepTypes[] = { { Machine::Stepping::TIMED, "Timed" },
+                               { Machine::Stepping::RMT, "RMT" },
+                               { Machine::Stepping::I2S_STATIC, "I2S_static" },
+                               { Machine::Stepping::I2S_STREAM, "I2S_stream" },
+                               EnumItem(Machine::Stepping::RMT) };
 
 namespace Machine {
 
     int Stepping::_engine = RMT;
 
-    const EnumItem stepTypes[] = { { Stepping::TIMED, "Timed" },
-                                   { Stepping::RMT, "RMT" },
-                                   { Stepping::I2S_STATIC, "I2S_static" },
-                                   { Stepping::I2S_STREAM, "I2S_stream" },
-                                   EnumItem(Stepping::RMT) };
-
     void Stepping::init() {
         log_info("Stepping:" << stepTypes[_engine].name << " Pulse:" << _pulseUsecs << "us Dsbl Delay:" << _disableDelayUsecs
                              << "us Dir Delay:" << _directionDelayUsecs << "us Idle Delay:" << _idleMsecs << "ms");
+        log_info("Segments:" << _segments << " Period:" << 1000000 / _accelerationTicks << "us Lead Time:" << _segments * 1000 / _accelerationTicks
+                             << "ms Cruise Lead Time:" << _segments * 1000 / _cruiseTicks << "ms");
+
+        // Selects the pulse_func specialization, so it must come first
+        Stepper::init();
 
         // Prepare stepping interrupt callbacks.  The one that is actually
         // used is determined by timerStart() and timerStop()
@@ -29,8 +35,6 @@ namespace Machine {
         // Register pulse_func with the I2S subsystem
         // This could be done via the linker.
         //        i2s_out_set_pulse_callback(Stepper::pulse_func);
-
-        Stepper::init();
     }
 
     void Stepping::reset() {
@@ -104,9 +108,9 @@ namespace Machine {
         }
     }
 
-    // Called only from Stepper::pulse_func when a new segment is loaded
+    // Called only from Stepper::pulse_func when the step period changes
     // The argument is in units of ticks of the timer that generates ISRs
-    void IRAM_ATTR Stepping::setTimerPeriod(uint16_t timerTicks) {
+    void IRAM_ATTR Stepping::setTimerPeriod(uint32_t timerTicks) {
         if (_engine == I2S_STREAM) {
             // Pulse ISR is called for each tick of alarm_val.
             // The argument to i2s_out_set_pulse_period is in units of microseconds
@@ -139,10 +143,36 @@ namespace Machine {
         handler.item("pulse_us", _pulseUsecs, 0, 30);
         handler.item("dir_delay_us", _directionDelayUsecs, 0, 10);
         handler.item("disable_delay_us", _disableDelayUsecs, 0, 1000000);  // max 1 second
-        handler.item("segments", _segments, 6, 20);
+        handler.item("segments", _segments, 6, 128);
+        handler.item("segment_buffer_ms", _bufferMsecs, 0, 1000);
+        handler.item("acceleration_ticks_per_sec", _accelerationTicks, 50, 1000);
+        handler.item("cruise_ticks_per_sec", _cruiseTicks, 0, 1000);
+        handler.item("prep_task", _prepTask);
+        handler.item("rmt_burst", _rmtBurst);
+        handler.item("underrun_guard_ms", _underrunGuardMs, 0, 1000);
+        handler.item("report_stats", _reportStats);
     }
 
     void Stepping::afterParse() {
+        if (_cruiseTicks == 0) {
+            _cruiseTicks = _accelerationTicks;
+        } else if (_bufferMsecs && _cruiseTicks != _accelerationTicks) {
+            log_warn("Ignoring stepping/cruise_ticks_per_sec because stepping/segment_buffer_ms bounds the lead time");
+            _cruiseTicks = _accelerationTicks;
+        } else if (_cruiseTicks > _accelerationTicks) {
+            log_warn("Decreasing stepping/cruise_ticks_per_sec to acceleration_ticks_per_sec " << _accelerationTicks);
+            _cruiseTicks = _accelerationTicks;
+        } else if (_cruiseTicks < minCruiseTicks()) {
+            log_warn("Increasing stepping/cruise_ticks_per_sec to " << minCruiseTicks());
+            _cruiseTicks = minCruiseTicks();
+        }
+        if (_bufferMsecs) {
+            uint32_t segments = (_bufferMsecs * _accelerationTicks + 999) / 1000;
+            _segments         = std::clamp(segments, uint32_t(6), uint32_t(128));
+            if (_segments != segments) {
+                log_warn("stepping/segment_buffer_ms needs " << segments << " segments, using " << _segments);
+            }
+        }
         if (_engine == I2S_STREAM || _engine == I2S_STATIC) {
             Assert(config->_i2so, "I2SO bus must be configured for this stepping type");
             if (_pulseUsecs < I2S_OUT_USEC_PER_PULSE) {
@@ -168,4 +198,9 @@ namespace Machine {
                 return 80000;  // based on testing
         }
     }
+
+    // A segment holds at most 65535 steps, and its distance is a Q16 step count in 32 bits.
+    // Cruise segments up to four times as long as acceleration segments last at most 1/12
+    // second, and stay below that even at the 500 kHz step rate of the fastest engine.
+    uint32_t Stepping::minCruiseTicks() { return (_accelerationTicks + 3) / 4; }
 }
@@ -33,12 +33,49 @@ namespace Machine {
 
         // _segments is the number of entries in the step segment buffer between the step execution algorithm
         // and the planner blocks. Each segment is set of steps executed at a constant velocity over a
-        // fixed time defined by ACCELERATION_TICKS_PER_SECOND. They are computed such that the planner
+        // fixed time defined by _accelerationTicks. They are computed such that the planner
         // block velocity profile is traced exactly. The size of this buffer governs how much step
         // execution lead time there is for other processes to run.  The latency for a feedhold or other
-        // override is roughly 10 ms times _segments.
-
-        size_t _segments = 12;
+        // override is roughly the segment time times _segments.
+
+        uint32_t _segments = 12;
+
+        // The lead time the segment buffer should hold, in milliseconds.  When set, _segments is computed
+        // from it and _accelerationTicks, so that feedhold latency and the protection against protocol
+        // loop stalls stay the same whatever the segment period.  Cruise segments then use _accelerationTicks
+        // too, since longer ones would stretch the lead time and the feedhold latency past this bound.
+        uint32_t _bufferMsecs = 0;
+
+        // The temporal resolution of the acceleration management subsystem, in segments per second.
+        // A higher number gives smoother acceleration, particularly noticeable on machines that run at
+        // very high feedrates or accelerations, but costs more segment computations.  It also shortens
+        // the time stored in the segment buffer, so _segments may need to grow with it.
+        uint32_t _accelerationTicks = 100;
+
+        // Segments per second while cruising.  There is no acceleration to trace then, so longer
+        // segments lose nothing and save computation, though a feedhold may take a little longer to
+        // begin.  Zero uses _accelerationTicks.  Values below minCruiseTicks() are raised to it.  Ignored
+        // when _bufferMsecs is set.
+        uint32_t _cruiseTicks = 0;
+
+        // Prep segments in a task of their own on the other core, woken by the step ISR when the
+        // segment buffer is half empty, instead of in the protocol loop.  Then a slow G-code line or
+        // SD card read cannot starve the segment buffer.
+        bool _prepTask = false;
+
+        // With the RMT engine, hand the steps of each moving axis to the RMT channels of its motors
+        // in trains, each axis at its own step period, instead of starting every step from the step
+        // ISR.  Fast moves then take one interrupt per window of steps rather than one per step.
+        bool _rmtBurst = false;
+
+        // When the segment buffer holds less than this much motion, the segment generator is falling
+        // behind; slow down, as a feed override would, instead of stopping dead when it runs dry.
+        // Zero disables it.
+        uint32_t _underrunGuardMs = 0;
+
+        // Time the step ISR, and add its times and the segment buffer figures from $Stepper/Stats
+        // to status reports.  The ISR is only timed when this is set.
+        bool _reportStats = false;
 
         uint32_t _idleMsecs           = 255;
         uint32_t _pulseUsecs          = 4;
@@ -60,9 +97,10 @@ namespace Machine {
         void finishPulse();    // Cleanup after unstep
 
         uint32_t maxPulsesPerSec();
+        uint32_t minCruiseTicks();
 
         // Timers
-        void        setTimerPeriod(uint16_t timerTicks);
+        void        setTimerPeriod(uint32_t timerTicks);
         void        startTimer();
         static void stopTimer();
 
@@ -28,6 +28,7 @@ void system_reset() {
     sys.f_override        = FeedOverride::Default;          // Set to 100%
     sys.r_override        = RapidOverride::Default;         // Set to 100%
     sys.spindle_speed_ovr = SpindleSpeedOverride::Default;  // Set to 100%
+    sys.underrun_scale    = UnderrunScale::Default;         // Set to 100%
     memset(probe_steps, 0, sizeof(probe_steps));            // Clear probe position.
     report_ovr_counter = 0;
     report_wco_counter = 0;
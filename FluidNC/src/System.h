@@ -47,6 +47,7 @@ struct system_t {
     Percent        f_override;         // Feed rate override value in percent
     Percent        r_override;         // Rapids override value in percent
     Percent        spindle_speed_ovr;  // Spindle speed value in percent
+    Percent        underrun_scale;     // Automatic speed scaling when the segment buffer runs low, in percent
     Override       override_ctrl;      // Tracks override control states.
     SpindleSpeed   spindle_speed;
 };
@@ -13,9 +13,10 @@
 #include "../Settings.h"
 #include "../Machine/MachineConfig.h"
 #include "../Configuration/JsonGenerator.h"
-#include "../Uart.h"       // Uart0.baud
-#include "../Report.h"     // git_info
-#include "../InputFile.h"  // InputFile
+#include "../Uart.h"           // Uart0.baud
+#include "../Report.h"         // git_info
+#include "../InputFile.h"      // InputFile
+#include "../MotionControl.h"  // mc_start_held_motion
 
 #include "Commands.h"  // COMMANDS::restart_MCU();
 #include "WifiConfig.h"
@@ -44,12 +45,12 @@ namespace WebUI {
     } keyval_t;
 
     bool get_param(const char* parameter, const char* key, std::string& s) {
-        char* start = strstr(parameter, key);
+        const char* start = strstr(parameter, key);
         if (!start) {
             return false;
         }
         s = "";
-        for (char* p = start + strlen(key); *p; ++p) {
+        for (const char* p = start + strlen(key); *p; ++p) {
             if (*p == ' ') {
                 break;  // Unescaped space
             }
@@ -578,6 +579,7 @@ namespace WebUI {
             log_string(out, "Alarm");
             return Error::IdleError;
         }
+        mc_start_held_motion();
         if (!state_is(State::Idle)) {
             log_string(out, "Busy");
             return Error::IdleError;
@@ -779,14 +781,14 @@ namespace WebUI {
         if (!parameter || *parameter == '\0') {
             return Error::InvalidValue;
         }
-        auto opath = strchr(parameter, '>');
-        if (*opath == '\0') {
+        auto sep = strchr(parameter, '>');
+        if (!sep) {
             return Error::InvalidValue;
         }
-        const char* ipath = parameter;
-        *opath++          = '\0';
+        std::string ipath(parameter, sep - parameter);
+        const char* opath = sep + 1;
         try {
-            FluidPath inPath { ipath, fs };
+            FluidPath inPath { ipath.c_str(), fs };
             FluidPath outPath { opath, fs };
             std::filesystem::rename(inPath, outPath);
             HashFS::rename_file(inPath, outPath, true);
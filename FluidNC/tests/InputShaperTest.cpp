@@ -0,0 +1,114 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/InputShaper.h"
+
+#include <cmath>
+
+namespace {
+    const float minute  = 60.0f;  // Stepper.cpp times are in minutes
+    const int   types[] = { InputShaper::ZV, InputShaper::ZVD, InputShaper::EI };
+
+    InputShaper make_shaper(int type, float hz) {
+        InputShaper shaper;
+        shaper.set(type, 1.0f / (hz * minute));
+        return shaper;
+    }
+
+}
+
+TEST(InputShaper, ImpulsesSumToOne) {
+    for (int type : types) {
+        auto  shaper = make_shaper(type, 40.0f);
+        float sum    = 0.0f;
+        float moment = 0.0f;
+        for (int i = 0; i < shaper.n_impulses; i++) {
+            sum += shaper.amplitude[i];
+            moment += shaper.amplitude[i] * shaper.delay[i];
+        }
+        EXPECT_FLOAT_EQ(sum, 1.0f) << "type " << type;
+        EXPECT_FLOAT_EQ(moment, shaper.duration() / 2) << "type " << type << " is not symmetric";
+    }
+    EXPECT_EQ(make_shaper(InputShaper::None, 40.0f).n_impulses, 0);
+}
+
+TEST(InputShaper, RampMatchesConstantAcceleration) {
+    // A shaped ramp must end at the same time, speed and distance as the planner's ramp.
+    for (int type : types) {
+        auto       shaper = make_shaper(type, 30.0f);
+        float      accel  = 500.0f * minute * minute;
+        ShapedRamp ramp   = { &shaper, 600.0f, 5400.0f, 5400.0f / accel };
+        ASSERT_TRUE(ShapedRamp::fits(shaper, ramp.duration));
+
+        float linear = ramp.duration * (ramp.start_speed + 0.5f * ramp.delta_speed);
+        EXPECT_NEAR(ramp.speed(ramp.duration), 6000.0f, 1e-2f);
+        EXPECT_NEAR(ramp.distance(ramp.duration), linear, linear * 1e-5f);
+        EXPECT_FLOAT_EQ(ramp.speed(0.0f), ramp.start_speed);
+
+        // Speed rises monotonically and never overshoots.
+        float last = ramp.start_speed;
+        for (int i = 1; i <= 100; i++) {
+            float v = ramp.speed(ramp.duration * i / 100);
+            EXPECT_GE(v, last - 1e-3f);
+            EXPECT_LE(v, 6000.0f + 1e-2f);
+            last = v;
+        }
+    }
+}
+
+TEST(InputShaper, ShortRampsAreNotShaped) {
+    auto shaper = make_shaper(InputShaper::ZVD, 20.0f);
+    EXPECT_FALSE(ShapedRamp::fits(shaper, 0.95f * ShapedRamp::min_ramp * shaper.duration()));
+    EXPECT_TRUE(ShapedRamp::fits(shaper, ShapedRamp::min_ramp * shaper.duration()));
+}
+
+TEST(InputShaper, PeakAccelerationIsBounded) {
+    // The shortest ramp that is shaped has the steepest peak, which the planner allows for.
+    for (int type : types) {
+        auto       shaper  = make_shaper(type, 20.0f);
+        ShapedRamp ramp    = { &shaper, 0.0f, 6000.0f, ShapedRamp::min_ramp * shaper.duration() };
+        float      average = ramp.delta_speed / ramp.duration;
+        float      dt      = ramp.duration / 1000;
+        float      peak    = 0.0f;
+        for (int i = 0; i < 1000; i++) {
+            peak = std::max(peak, (ramp.speed((i + 1) * dt) - ramp.speed(i * dt)) / dt);
+        }
+        EXPECT_LE(peak, average * ShapedRamp::peak_ratio * 1.001f) << "type " << type;
+        EXPECT_GE(peak, average * ShapedRamp::peak_ratio * 0.999f) << "type " << type;
+    }
+}
+
+TEST(InputShaper, CancelsResonance) {
+    // Residual vibration of an undamped 25 Hz resonance after an acceleration ramp.  The shapers
+    // are tuned to the resonance, so the residual should all but vanish.
+    const float hz       = 25.0f;
+    const float w        = 2 * float(M_PI) * hz * minute;
+    auto        residual = [w](auto speed, float duration) {
+        // Integrate x'' = -w^2 (x - position) in the frame of the commanded position, where the
+        // forcing term is the commanded acceleration.
+        double x = 0, v = 0, h = duration / 20000;
+        double last_speed = speed(0.0f);
+        for (int i = 1; i <= 20000; i++) {
+            double s = speed(float(i * h));
+            double a = (s - last_speed) / h;
+            last_speed = s;
+            v += (-w * w * x - a) * h;
+            x += v * h;
+        }
+        return std::sqrt(x * x + v * v / (w * w));
+    };
+
+    const float accel    = 2000.0f * minute * minute;
+    const float dv       = 6000.0f;
+    const float duration = dv / accel;
+    for (int type : types) {
+        // Compare with the unshaped base ramp of the shaped ramp, which excites the resonance the most.
+        auto       shaper = make_shaper(type, hz);
+        ShapedRamp ramp   = { &shaper, 0.0f, dv, duration };
+        float      base   = ramp.base();
+        double     plain  = residual([=](float t) { return std::min(t, base) * dv / base; }, duration);
+        double     shaped = residual([&](float t) { return ramp.speed(t); }, duration);
+        // EI deliberately leaves 5% at its design frequency in exchange for a wider notch.
+        EXPECT_LT(shaped, (type == InputShaper::EI ? 0.06 : 0.01) * plain) << "type " << type;
+    }
+}
@@ -0,0 +1,163 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/PlannerRecalculate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    struct Block {
+        float     entry_speed_sqr;
+        float     max_entry_speed_sqr;
+        float     acceleration;
+        float     millimeters;
+        PlanFlags flags;
+    };
+
+    // Counts the block accesses made by the passes, which is the work done per append.
+    struct CountingRing {
+        std::vector<Block> blocks;
+        size_t             visits = 0;
+
+        Block& operator[](uint8_t index) {
+            ++visits;
+            return blocks[index];
+        }
+    };
+
+    // A stripped-down Planner.cpp: a ring of blocks with the same pointer handling.
+    struct Planner {
+        CountingRing ring;
+        uint8_t      size;
+        uint8_t      tail    = 0;
+        uint8_t      head    = 0;
+        uint8_t      planned = 0;
+        float        previous_nominal_speed;
+        bool         full;
+        size_t       tail_updates = 0;
+
+        Planner(uint8_t blocks, bool full = false) : size(blocks), previous_nominal_speed(0.0f), full(full) {
+            ring.blocks.resize(blocks);
+        }
+
+        uint8_t next(uint8_t index) const { return index + 1 == size ? 0 : index + 1; }
+        bool    is_full() const { return next(head) == tail; }
+        size_t  count() const { return head >= tail ? head - tail : head + size - tail; }
+
+        void append(float millimeters, float nominal_speed, float junction_speed_sqr, float acceleration) {
+            Block& block              = ring.blocks[head];
+            block                     = Block();
+            block.millimeters         = millimeters;
+            block.acceleration        = acceleration;
+            block.max_entry_speed_sqr = std::min(nominal_speed, previous_nominal_speed);
+            block.max_entry_speed_sqr *= block.max_entry_speed_sqr;
+            block.max_entry_speed_sqr = std::min(block.max_entry_speed_sqr, head == tail ? 0.0f : junction_speed_sqr);
+            block.flags.nominalLength = nominal_speed * nominal_speed <= 2 * acceleration * millimeters;
+            previous_nominal_speed    = nominal_speed;
+            head                      = next(head);
+            if (full) {
+                planned = tail;
+            }
+            plan_recalculate_ring(ring, size, tail, head, planned, full, [this]() { ++tail_updates; });
+        }
+
+        void discard() {
+            uint8_t index = next(tail);
+            if (tail == planned) {
+                planned = index;
+            }
+            tail = index;
+        }
+    };
+
+    // Optimal entry speeds from scratch, keeping the entry speed of the executing tail block.
+    std::vector<float> reference_plan(const Planner& planner) {
+        const auto&        blocks = planner.ring.blocks;
+        std::vector<float> entry(planner.count());
+        std::vector<Block> order;
+        for (uint8_t index = planner.tail; index != planner.head; index = planner.next(index)) {
+            order.push_back(blocks[index]);
+        }
+        size_t n = order.size();
+        entry[0] = order[0].entry_speed_sqr;
+        float exit = 0.0f;
+        for (size_t i = n - 1; i > 0; --i) {
+            entry[i] = std::min(order[i].max_entry_speed_sqr, exit + 2 * order[i].acceleration * order[i].millimeters);
+            exit     = entry[i];
+        }
+        for (size_t i = 1; i < n; ++i) {
+            entry[i] = std::min(entry[i], entry[i - 1] + 2 * order[i - 1].acceleration * order[i - 1].millimeters);
+        }
+        return entry;
+    }
+
+    const float accel = 500.0f * 60 * 60;  // mm/min^2
+}
+
+TEST(PlannerRecalculate, MatchesFullReplan) {
+    Planner  planner(32);
+    uint32_t seed = 12345;
+    auto     rnd  = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return float((seed >> 8) & 0xffff) / 65536.0f;
+    };
+
+    for (int n = 0; n < 2000; ++n) {
+        if (planner.is_full() || rnd() < 0.3f) {
+            if (planner.count() > 1) {
+                planner.discard();
+            }
+        }
+        float millimeters = 0.02f + 5.0f * rnd() * rnd();
+        float nominal     = 500.0f + 4000.0f * rnd();
+        float junction    = 1e7f * rnd() * rnd();
+        planner.append(millimeters, nominal, junction, accel);
+
+        auto    expected = reference_plan(planner);
+        uint8_t index    = planner.tail;
+        for (size_t i = 0; i < expected.size(); ++i, index = planner.next(index)) {
+            ASSERT_NEAR(planner.ring.blocks[index].entry_speed_sqr, expected[i], 1e-3f * std::max(1.0f, expected[i]))
+                << "append " << n << " block " << i;
+        }
+    }
+}
+
+TEST(PlannerRecalculate, AppendCostIsFlat) {
+    // Streams 0.1 mm segments at 3000 mm/min with 500 mm/s^2, which need about 25 blocks to stop.
+    // Once the buffer holds more than that, the work per append must not grow with the buffer.
+    const uint8_t sizes[] = { 16, 32, 64, 128, 192, 255 };
+    const int     moves   = 20000;
+    double        visits[sizeof(sizes)];
+    printf("planner_blocks  visits/append  ns/append  (full replan: visits/append  ns/append)\n");
+    for (size_t s = 0; s < sizeof(sizes); ++s) {
+        double ns[2];
+        double per_append[2];
+        for (int full = 0; full < 2; ++full) {
+            Planner planner(sizes[s], full);
+            for (int n = 0; n < sizes[s]; ++n) {
+                planner.append(0.1f, 3000.0f, 1e9f, accel);
+                if (planner.is_full()) {
+                    planner.discard();
+                }
+            }
+            planner.ring.visits = 0;
+            auto start          = std::chrono::steady_clock::now();
+            for (int n = 0; n < moves; ++n) {
+                planner.discard();
+                planner.append(0.1f, 3000.0f, 1e9f, accel);
+            }
+            auto elapsed     = std::chrono::steady_clock::now() - start;
+            ns[full]         = std::chrono::duration<double, std::nano>(elapsed).count() / moves;
+            per_append[full] = double(planner.ring.visits) / moves;
+        }
+        visits[s] = per_append[0];
+        printf("%14d  %13.1f  %9.1f  (%26.1f  %9.1f)\n", sizes[s], per_append[0], ns[0], per_append[1], ns[1]);
+    }
+    for (size_t s = 3; s < sizeof(sizes); ++s) {
+        EXPECT_LE(visits[s], visits[2] * 1.1 + 2) << "planner_blocks " << int(sizes[s]);
+    }
+}
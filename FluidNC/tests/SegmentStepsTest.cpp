@@ -0,0 +1,171 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/SegmentSteps.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    const float ticks_per_minute = 20000000.0f * 60;  // fStepperTimer
+
+    // The floating point conversion that SegmentSteps replaced in Stepper::prep_buffer().
+    struct FloatSteps {
+        float steps_remaining;
+        float dt_remainder;  // minutes
+        float step_dist_remaining;
+        float n_steps_remaining;
+        float last_n_steps_remaining;
+
+        void start(uint32_t step_event_count) {
+            steps_remaining = float(step_event_count);
+            dt_remainder    = 0.0f;
+        }
+        uint32_t segment_steps(float dist) {
+            step_dist_remaining    = dist;
+            n_steps_remaining      = ceilf(step_dist_remaining);
+            last_n_steps_remaining = ceilf(steps_remaining);
+            return uint32_t(last_n_steps_remaining - n_steps_remaining);
+        }
+        uint32_t finish(float dt_ticks) {
+            float    dt       = dt_ticks / ticks_per_minute + dt_remainder;
+            float    inv_rate = dt / (last_n_steps_remaining - step_dist_remaining);
+            uint32_t ticks    = uint32_t(ceilf(ticks_per_minute * inv_rate));
+            steps_remaining = n_steps_remaining;
+            dt_remainder    = (n_steps_remaining - step_dist_remaining) * inv_rate;
+            return ticks;
+        }
+    };
+
+    struct Segment {
+        float step_dist_remaining;
+        float dt_ticks;
+    };
+
+    // Segments of a trapezoidal move as prep_buffer would slice it: 10 ms each, at least one step.
+    std::vector<Segment> make_block(uint32_t steps, float accel, float nominal) {
+        std::vector<Segment> segments;
+        const float          dt    = 0.01f;
+        float                speed = 0.0f;
+        float                left  = float(steps);
+        while (left > 0.0f) {
+            float stop = speed * speed / (2 * accel);
+            speed      = stop >= left ? std::max(speed - accel * dt, accel * dt) : std::min(speed + accel * dt, nominal);
+            left       = std::max(left - speed * dt, 0.0f);
+            segments.push_back({ left, dt * ticks_per_minute / 60 });
+        }
+        return segments;
+    }
+
+    template <typename Steps>
+    void run(Steps& steps, uint32_t count, const std::vector<Segment>& segments, std::vector<uint32_t>& n, std::vector<uint32_t>& ticks) {
+        steps.start(count);
+        n.clear();
+        ticks.clear();
+        for (auto& segment : segments) {
+            n.push_back(steps.segment_steps(segment.step_dist_remaining));
+            ticks.push_back(steps.finish(segment.dt_ticks));
+        }
+    }
+}
+
+TEST(SegmentSteps, MatchesFloat) {
+    // Speeds in steps/s and accelerations in steps/s^2
+    struct {
+        uint32_t steps;
+        float    accel;
+        float    nominal;
+    } moves[] = { { 1, 1000, 100 }, { 10, 1000, 100 }, { 8000, 40000, 16000 }, { 123457, 200000, 80000 }, { 3000000, 500000, 150000 } };
+
+    for (auto& move : moves) {
+        auto                  segments = make_block(move.steps, move.accel, move.nominal);
+        FloatSteps            reference;
+        SegmentSteps          fixed;
+        std::vector<uint32_t> n_float, ticks_float, n_fixed, ticks_fixed;
+        run(reference, move.steps, segments, n_float, ticks_float);
+        run(fixed, move.steps, segments, n_fixed, ticks_fixed);
+
+        uint64_t total = 0;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            ASSERT_EQ(n_fixed[i], n_float[i]) << move.steps << " steps, segment " << i;
+            total += n_fixed[i];
+            if (n_fixed[i]) {
+                // The float version rounds too; the periods must agree to within that.
+                EXPECT_NEAR(double(ticks_fixed[i]), double(ticks_float[i]), 1 + 1e-5 * ticks_float[i]) << move.steps << " steps, segment " << i;
+            }
+        }
+        EXPECT_EQ(total, move.steps);
+    }
+}
+
+TEST(SegmentSteps, CarriesPartialSteps) {
+    // A constant 1234.5 steps/s split into 10 ms segments: every segment ends on a partial step.
+    // Carrying its time must keep the step times from drifting; they may only run late by the
+    // rounding up of each period to whole ticks.
+    SegmentSteps fixed;
+    uint32_t     count = 12345;
+    fixed.start(count);
+    uint64_t elapsed = 0;
+    uint32_t emitted = 0;
+    float    dt      = 0.01f * ticks_per_minute / 60;
+    float    last    = float(count);
+    for (int i = 1; fixed.steps_remaining; ++i) {
+        float    left = std::max(float(count) - 12.345f * i, 0.0f);
+        uint32_t n    = fixed.segment_steps(left);
+        elapsed += uint64_t(n) * fixed.finish(dt);
+        emitted += n;
+        // When the last step of the segment is due, interpolating the distance within the segment
+        double exact = (i - 1 + (double(last) - (count - emitted)) / (double(last) - left)) * dt;
+        ASSERT_GE(double(elapsed), exact - 1.0) << "segment " << i;
+        ASSERT_LE(double(elapsed), exact + emitted) << "segment " << i;
+        last = left;
+    }
+}
+
+TEST(SegmentSteps, ExactPeriodDoesNotDrift) {
+    // The same move, stepped with the exact period that the ISR dithers the timer to.  Now the step
+    // times should neither run late nor drift, over a move of 10 seconds.
+    SegmentSteps fixed;
+    uint32_t     count = 12345;
+    fixed.start(count);
+    uint64_t elapsed = 0;  // Q16 ticks
+    uint32_t emitted = 0;
+    float    dt      = 0.01f * ticks_per_minute / 60;
+    float    last    = float(count);
+    for (int i = 1; fixed.steps_remaining; ++i) {
+        float    left = std::max(float(count) - 12.345f * i, 0.0f);
+        uint32_t n    = fixed.segment_steps(left);
+        fixed.finish(dt);
+        elapsed += uint64_t(n) * fixed.period;
+        emitted += n;
+        double exact = (i - 1 + (double(last) - (count - emitted)) / (double(last) - left)) * dt;
+        ASSERT_NEAR(double(elapsed) / (1 << SegmentSteps::tick_shift), exact, 1.0) << "segment " << i;
+        last = left;
+    }
+}
+
+// Times the host only.  The ESP32 does the 64-bit divides of SegmentSteps::finish() in software.
+TEST(SegmentSteps, Benchmark) {
+    auto                  segments = make_block(3000000, 500000, 150000);
+    std::vector<uint32_t> n, ticks;
+    const int             passes = 20;
+
+    FloatSteps reference;
+    auto       start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        run(reference, 3000000, segments, n, ticks);
+    }
+    double float_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    SegmentSteps fixed;
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        run(fixed, 3000000, segments, n, ticks);
+    }
+    double fixed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    double count = double(passes) * segments.size();
+    printf("segment step conversion: float %.1f ns/segment, fixed point %.1f ns/segment\n", float_ns / count, fixed_ns / count);
+}
@@ -62,6 +62,9 @@ uint64_t EspClass::getEfuseMac() {
 uint32_t EspClass::getCpuFreqMHz() {
     return 240;
 }
+uint8_t EspClass::getChipCores() {
+    return 2;
+}
 const char* EspClass::getSdkVersion() {
     return "v1.0-UnitTest-foobar";
 }
@@ -208,6 +208,14 @@ std::exception CreateException(const char* condition, const char* msg) {
 
 #else
 
+#    include <sstream>
+#    include <stdexcept>
+#    include <string>
+
+void DumpStackTrace(std::ostringstream& builder) {
+    builder << "(no stack trace on this platform)" << std::endl;
+}
+
 std::exception CreateException(const char* condition, const char* msg) {
     static std::string container;  // Exception data _must_ be stored in a static string!
     std::ostringstream oss;
@@ -215,7 +223,7 @@ std::exception CreateException(const char* condition, const char* msg) {
     oss << "Error: " << condition << " failed: " << msg << " at: " << std::endl;
 
     container = oss.str();
-    return std::exception(container.c_str()); /* this is usually where you want a breakpoint. */
+    return std::runtime_error(container); /* this is usually where you want a breakpoint. */
 }
 
 #endif
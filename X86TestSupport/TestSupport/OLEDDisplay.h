@@ -0,0 +1,88 @@
+#pragma once
+
+// Host stand-in for the ThingPulse SSD1306 driver base class.  Drawing calls are
+// accepted and discarded; only the buffer geometry is tracked.
+
+#include <cstdint>
+
+enum OLEDDISPLAY_GEOMETRY { GEOMETRY_128_64 = 0, GEOMETRY_128_32 = 1, GEOMETRY_64_48 = 2, GEOMETRY_64_32 = 3, GEOMETRY_RAWMODE = 4 };
+
+enum OLEDDISPLAY_TEXT_ALIGNMENT { TEXT_ALIGN_LEFT = 0, TEXT_ALIGN_RIGHT = 1, TEXT_ALIGN_CENTER = 2, TEXT_ALIGN_CENTER_BOTH = 3 };
+
+enum OLEDDISPLAY_COLOR { BLACK = 0, WHITE = 1, INVERSE = 2 };
+
+#define COLUMNADDR 0x21
+#define PAGEADDR 0x22
+
+// Fonts are a width, height, first character and character count header
+// followed by four bytes per glyph.  All glyphs here are empty.
+#define OLED_HOST_FONT(name, w, h) const uint8_t name[4 + 4 * 96] = { w, h, 32, 96 }
+static OLED_HOST_FONT(ArialMT_Plain_10, 10, 13);
+static OLED_HOST_FONT(ArialMT_Plain_16, 16, 19);
+static OLED_HOST_FONT(ArialMT_Plain_24, 24, 28);
+#undef OLED_HOST_FONT
+
+class OLEDDisplay {
+protected:
+    uint8_t  _buffer[1 + 128 * 64 / 8] = {};
+    uint8_t* buffer            = _buffer + 1;  // Drivers write a control byte at buffer[-1]
+    uint8_t* buffer_back       = nullptr;
+    int      displayBufferSize = 128 * 64 / 8;
+    int      displayWidth      = 128;
+    int      displayHeight     = 64;
+
+    OLEDDISPLAY_GEOMETRY geometry = GEOMETRY_128_64;
+
+    virtual void sendCommand(uint8_t command) {}
+    virtual bool connect() { return true; }
+    virtual int  getBufferOffset(void) { return 0; }
+
+public:
+    virtual ~OLEDDisplay() {}
+
+    virtual void display(void) {}
+
+    void setGeometry(OLEDDISPLAY_GEOMETRY g, uint16_t width = 0, uint16_t height = 0) {
+        geometry = g;
+        switch (g) {
+            case GEOMETRY_128_32:
+                displayWidth  = 128;
+                displayHeight = 32;
+                break;
+            case GEOMETRY_64_48:
+                displayWidth  = 64;
+                displayHeight = 48;
+                break;
+            case GEOMETRY_64_32:
+                displayWidth  = 64;
+                displayHeight = 32;
+                break;
+            case GEOMETRY_RAWMODE:
+                displayWidth  = width;
+                displayHeight = height;
+                break;
+            default:
+                displayWidth  = 128;
+                displayHeight = 64;
+                break;
+        }
+        displayBufferSize = displayWidth * displayHeight / 8;
+    }
+
+    bool init() { return connect(); }
+
+    uint16_t width(void) { return displayWidth; }
+    uint16_t height(void) { return displayHeight; }
+
+    void clear(void) {}
+    void flipScreenVertically() {}
+    void mirrorScreen() {}
+    void setColor(OLEDDISPLAY_COLOR color) {}
+    void setFont(const uint8_t* fontData) {}
+    void setTextAlignment(OLEDDISPLAY_TEXT_ALIGNMENT textAlignment) {}
+
+    void drawString(int16_t x, int16_t y, const char* text) {}
+    void drawRect(int16_t x, int16_t y, int16_t width, int16_t height) {}
+    void fillRect(int16_t x, int16_t y, int16_t width, int16_t height) {}
+    void drawProgressBar(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint8_t progress) {}
+};
@@ -3,12 +3,21 @@
 #include <iomanip>
 #include <sstream>
 
-#pragma warning(disable : 4996)  // itoa
-
+// itoa() is not available outside of MSVC
 std::string String::ValueToString(int value, int base) {
-    char        buffer[100] = { 0 };
-    int         number_base = 10;
-    std::string output      = itoa(value, buffer, base);
+    if (base < 2 || base > 36) {
+        base = 10;
+    }
+    bool         negative = value < 0 && base == 10;
+    unsigned int number   = negative ? -unsigned(value) : unsigned(value);
+    std::string  output;
+    do {
+        output.insert(output.begin(), "0123456789abcdefghijklmnopqrstuvwxyz"[number % base]);
+        number /= base;
+    } while (number);
+    if (negative) {
+        output.insert(output.begin(), '-');
+    }
     return output;
 }
 
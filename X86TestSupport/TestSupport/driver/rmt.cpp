@@ -1,16 +1,39 @@
 #include "rmt.h"
 
 rmt_dev_t RMT;
+rmt_mem_t RMTMEM;
+
+static int channel_gpio[RMT_CHANNEL_MAX] = { -1, -1, -1, -1, -1, -1, -1, -1 };
 
 esp_err_t rmt_set_source_clk(rmt_channel_t channel, rmt_source_clk_t base_clk) {
     return ESP_OK;
 }
 
+// Only the transmitter settings that shape the output are kept.
 esp_err_t rmt_config(const rmt_config_t* rmt_param) {
-    // TODO: figure out the stuff that matter, and push them.
+    auto channel = rmt_param->channel;
+    if (channel < RMT_CHANNEL_0 || channel >= RMT_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    RMT.conf_ch[channel].conf0.div_cnt  = rmt_param->clk_div;
+    RMT.conf_ch[channel].conf0.mem_size = rmt_param->mem_block_num;
+    if (rmt_param->rmt_mode == RMT_MODE_TX) {
+        RMT.conf_ch[channel].conf1.idle_out_lv = rmt_param->tx_config.idle_level;
+        RMT.conf_ch[channel].conf1.idle_out_en = rmt_param->tx_config.idle_output_en;
+    }
+    channel_gpio[channel] = rmt_param->gpio_num;
     return ESP_OK;
 }
 esp_err_t rmt_fill_tx_items(rmt_channel_t channel, const rmt_item32_t* item, uint16_t item_num, uint16_t mem_offset) {
-    // TODO: figure out the stuff that matter, and push them.
+    if (channel < RMT_CHANNEL_0 || channel >= RMT_CHANNEL_MAX || mem_offset + item_num > SOC_RMT_MEM_WORDS_PER_CHANNEL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint16_t i = 0; i < item_num; i++) {
+        RMTMEM.chan[channel].data32[mem_offset + i].val = item[i].val;
+    }
     return ESP_OK;
 }
+
+int rmt_host_gpio(rmt_channel_t channel) {
+    return channel >= RMT_CHANNEL_0 && channel < RMT_CHANNEL_MAX ? channel_gpio[channel] : -1;
+}
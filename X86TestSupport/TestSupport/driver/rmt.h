@@ -17,6 +17,10 @@
 #include <cstdint>
 
 #include "../esp_err.h"
+#include "../esp32-hal-gpio.h"  // gpio_num_t
+
+#define SOC_RMT_CHANNELS_PER_GROUP 8
+#define SOC_RMT_MEM_WORDS_PER_CHANNEL 64
 
 typedef struct rmt_item32_s {
     union {
@@ -70,12 +74,12 @@ typedef enum {
      * @brief Data struct of RMT TX configure parameters
      */
 typedef struct {
-    bool                loop_en;              /*!< Enable sending RMT items in a loop */
     uint32_t            carrier_freq_hz;      /*!< RMT carrier frequency */
-    uint8_t             carrier_duty_percent; /*!< RMT carrier duty (%) */
     rmt_carrier_level_t carrier_level;        /*!< Level of the RMT output, when the carrier is applied */
-    bool                carrier_en;           /*!< RMT carrier enable */
     rmt_idle_level_t    idle_level;           /*!< RMT idle level */
+    uint8_t             carrier_duty_percent; /*!< RMT carrier duty (%) */
+    bool                carrier_en;           /*!< RMT carrier enable */
+    bool                loop_en;              /*!< Enable sending RMT items in a loop */
     bool                idle_output_en;       /*!< RMT idle level output enable */
 } rmt_tx_config_t;
 
@@ -91,9 +95,10 @@ typedef struct {
 typedef struct {
     rmt_mode_t    rmt_mode;      /*!< RMT mode: transmitter or receiver */
     rmt_channel_t channel;       /*!< RMT channel */
+    gpio_num_t    gpio_num;      /*!< RMT GPIO number */
     uint8_t       clk_div;       /*!< RMT channel counter divider */
-    int           gpio_num;      /*!< RMT GPIO number */
     uint8_t       mem_block_num; /*!< RMT memory block number */
+    uint32_t      flags;         /*!< RMT channel extra configurations, OR'd with RMT_CHANNEL_FLAGS_[*] */
     union {
         rmt_tx_config_t tx_config; /*!< RMT TX parameter */
         rmt_rx_config_t rx_config; /*!< RMT RX parameter */
@@ -141,6 +146,10 @@ esp_err_t rmt_config(const rmt_config_t* rmt_param);
      */
 esp_err_t rmt_fill_tx_items(rmt_channel_t channel, const rmt_item32_t* item, uint16_t item_num, uint16_t mem_offset);
 
+// Host only: the GPIO that rmt_config() routed the channel's output to, or -1 if the channel is
+// not configured.  On the ESP32 this is held in the GPIO matrix rather than the RMT registers.
+int rmt_host_gpio(rmt_channel_t channel);
+
 typedef volatile struct rmt_dev_s {
     uint32_t data_ch[8]; /*The R/W ram address for channel0-7 by apb fifo access.
                                                         Note that in some circumstances, data read from the FIFO may get lost. As RMT memory area accesses using the RMTMEM method do not have this issue
@@ -356,3 +365,11 @@ typedef volatile struct rmt_dev_s {
 } rmt_dev_t;
 
 extern rmt_dev_t RMT;
+
+typedef volatile struct rmt_mem_s {
+    struct {
+        rmt_item32_t data32[SOC_RMT_MEM_WORDS_PER_CHANNEL];
+    } chan[SOC_RMT_CHANNELS_PER_GROUP];
+} rmt_mem_t;
+
+extern rmt_mem_t RMTMEM;
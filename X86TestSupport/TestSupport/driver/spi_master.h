@@ -0,0 +1,3 @@
+#pragma once
+
+typedef int spi_device_t;
@@ -9,5 +9,8 @@ using UBaseType_t   = unsigned int;
 using BaseType_t    = portBASE_TYPE;
 using TickType_t    = uint32_t;
 
+#define pdPASS ((BaseType_t)1)
+#define pdFAIL ((BaseType_t)0)
+
 typedef void (*TaskFunction_t)(void*);
 typedef void* TaskHandle_t;
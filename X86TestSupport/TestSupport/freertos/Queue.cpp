@@ -1,8 +1,9 @@
-#include "Queue.h"
+#include "queue.h"
 
 #include <atomic>
 #include <vector>
 #include <mutex>
+#include <cstring>
 
 QueueHandle_t xQueueGenericCreate(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, const uint8_t ucQueueType /* =0 */) {
     auto ptr         = new QueueHandle();
@@ -60,3 +61,10 @@ BaseType_t xQueueGenericReset(QueueHandle_t xQueue, BaseType_t xNewQueue) {
 BaseType_t xQueueGenericSend(QueueHandle_t xQueue, const void* const pvItemToQueue, TickType_t xTicksToWait, BaseType_t xCopyPosition) {
     return xQueueGenericSendFromISR(xQueue, pvItemToQueue, nullptr, xCopyPosition);
 }
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue) {
+    std::lock_guard<std::mutex> lock(xQueue->mutex);
+
+    auto used = xQueue->writeIndex + xQueue->data.size() - xQueue->readIndex;
+    return (used % xQueue->data.size()) / xQueue->entrySize;
+}
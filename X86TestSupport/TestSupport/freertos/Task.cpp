@@ -1,4 +1,4 @@
-#include "Task.h"
+#include "task.h"
 
 #include "Capture.h"
 #include "../Arduino.h"
@@ -25,6 +25,10 @@ BaseType_t xTaskCreatePinnedToCore(TaskFunction_t      pvTaskCode,
     return pdTRUE;
 }
 
+// std::thread cannot be paused from outside, so these are no-ops.
+void vTaskSuspend(TaskHandle_t xTaskToSuspend) {}
+void vTaskResume(TaskHandle_t xTaskToResume) {}
+
 void vTaskDelay(const TickType_t xTicksToDelay) {
     Capture::instance().wait(xTicksToDelay);
 }
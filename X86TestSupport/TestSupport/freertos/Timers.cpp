@@ -0,0 +1,21 @@
+#include "timers.h"
+
+TimerHandle_t xTimerCreate(const char* const       pcTimerName,
+                           const TickType_t        xTimerPeriodInTicks,
+                           const UBaseType_t       uxAutoReload,
+                           void* const             pvTimerID,
+                           TimerCallbackFunction_t pxCallbackFunction) {
+    return new TimerHandle { pcTimerName, xTimerPeriodInTicks, uxAutoReload != 0, pvTimerID, pxCallbackFunction };
+}
+
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait) {
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait) {
+    return pdPASS;
+}
+
+void* pvTimerGetTimerID(const TimerHandle_t xTimer) {
+    return xTimer->id;
+}
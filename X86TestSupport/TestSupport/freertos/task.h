@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Arduino.h"
+#include <climits>
 #include "FreeRTOS.h"
 #include "FreeRTOSTypes.h"
 
@@ -31,6 +32,9 @@ void vTaskDelayUntil(TickType_t* const pxPreviousWakeTime, const TickType_t xTim
 
 TickType_t xTaskGetTickCount(void);
 
+void vTaskSuspend(TaskHandle_t xTaskToSuspend);
+void vTaskResume(TaskHandle_t xTaskToResume);
+
 #define CONFIG_FREERTOS_HZ 1000
 #define configTICK_RATE_HZ (CONFIG_FREERTOS_HZ)
 #define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
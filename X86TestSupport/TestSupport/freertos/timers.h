@@ -0,0 +1,25 @@
+#pragma once
+
+#include "task.h"
+#include "FreeRTOSTypes.h"
+
+struct TimerHandle {
+    const char* name;
+    TickType_t  period;
+    bool        autoReload;
+    void*       id;
+    void (*callback)(TimerHandle*);
+};
+
+using TimerHandle_t           = TimerHandle*;
+using TimerCallbackFunction_t = void (*)(TimerHandle_t);
+
+// Timers are created and accepted but never fire; nothing on the host needs the periodic callbacks.
+TimerHandle_t xTimerCreate(const char* const       pcTimerName,
+                           const TickType_t        xTimerPeriodInTicks,
+                           const UBaseType_t       uxAutoReload,
+                           void* const             pvTimerID,
+                           TimerCallbackFunction_t pxCallbackFunction);
+BaseType_t    xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t    xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait);
+void*         pvTimerGetTimerID(const TimerHandle_t xTimer);
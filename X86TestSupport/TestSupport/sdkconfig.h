@@ -0,0 +1,4 @@
+#pragma once
+
+// Host builds follow the original ESP32 target.
+#define CONFIG_IDF_TARGET_ESP32 1